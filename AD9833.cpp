@@ -1,12 +1,13 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "AD9833.h"
-#include <SPI.h>
+#include "HAL.h"
+#include "SpiBus.h"
 
 //-----------------------------------------------------------------------------
 // Constructor for the AD9833 object, define select pin
 //-----------------------------------------------------------------------------
-AD9833::AD9833( uint8_t fsync ) : _FSYNC( fsync ) {}
+AD9833::AD9833( uint8_t fsync ) : _FSYNC( fsync ), _control( wReset ), _freqValid( 0 ), _phaseValid( 0 ) {}
 
 
 //-----------------------------------------------------------------------------
@@ -14,11 +15,12 @@ AD9833::AD9833( uint8_t fsync ) : _FSYNC( fsync ) {}
 //   reset the AD9833
 //-----------------------------------------------------------------------------
 void AD9833::reset() {
-    SPI.beginTransaction( SPISettings( 10000000, MSBFIRST, SPI_MODE3 ) );
-    digitalWrite( _FSYNC, LOW );
-    SPI.transfer16( wReset );
-    digitalWrite( _FSYNC, HIGH );
-    SPI.endTransaction();
+    SpiBus::begin();
+    halDigitalWrite( _FSYNC, LOW );
+    write16( wReset );
+    halDigitalWrite( _FSYNC, HIGH );
+    SpiBus::end();
+    _control = wReset;
 }
 
 
@@ -27,14 +29,215 @@ void AD9833::reset() {
 //    set the SG frequency and waveform regs
 //-----------------------------------------------------------------------------
 void AD9833::setFrequency( long frequency, uint16_t wave ) {
-    long fl = long( frequency * ( 0x10000000L / 25000000.0 ) + 0.5 );
-    SPI.beginTransaction( SPISettings( 10000000, MSBFIRST, SPI_MODE3 ) );
-    digitalWrite( _FSYNC, LOW );
-    SPI.transfer16( 0x2000 | wave );
-    SPI.transfer16( uint16_t( fl & 0x3FFFL ) | 0x4000 );
-    SPI.transfer16( uint16_t( ( fl & 0xFFFC000L ) >> 14 ) | 0x4000 );
-    digitalWrite( _FSYNC, HIGH );
-    SPI.endTransaction();
+    setFreqWord( freqWord( frequency ), wave );
+}
+
+
+//-----------------------------------------------------------------------------
+// setFrequency
+//    set the SG frequency with mHz resolution and waveform regs
+//-----------------------------------------------------------------------------
+void AD9833::setFrequency( uint32_t hz, uint16_t milliHz, uint16_t wave ) {
+    setFreqWord( freqWord( hz, milliHz ), wave );
+}
+
+
+//-----------------------------------------------------------------------------
+// freqWord
+//    convert a frequency in Hz and mHz into the 28 bit FREQ register value
+//    fw = round( f * 2^28 / MCLK ) = round( f * 2^23 / ( MCLK / 32 ) )
+//    exact integer math, no float, no 64 bit:
+//    the integer part of f / ( MCLK / 32 ) is shifted left 23 bits,
+//    the remainder ( in mHz ) is divided bitwise by shift and subtract
+//-----------------------------------------------------------------------------
+uint32_t AD9833::freqWord( uint32_t hz, uint16_t milliHz ) {
+    const uint32_t div = MCLK / 32;       // 781250
+    const uint32_t divMilli = div * 1000; // < 2^30
+    hz += milliHz / 1000;
+    uint32_t rem = ( hz % div ) * 1000 + milliHz % 1000; // < divMilli
+    uint32_t frac = 0;
+    for ( uint8_t bit = 0; bit < 23; ++bit ) {
+        rem <<= 1;
+        frac <<= 1;
+        if ( rem >= divMilli ) {
+            rem -= divMilli;
+            frac |= 1;
+        }
+    }
+    if ( 2 * rem >= divMilli ) // round
+        ++frac;
+    return ( ( hz / div ) << 23 ) + frac;
+}
+
+
+//-----------------------------------------------------------------------------
+// setFreqWord
+//    set the 28 bit FREQ0 register value and the waveform regs
+//    select FREQ0 for output
+//    no float math, used for the sweep steps
+//    nothing is sent if FREQ0 and CONTROL hold the values already
+//-----------------------------------------------------------------------------
+void AD9833::setFreqWord( uint32_t fw, uint16_t wave ) {
+    SpiBus::begin();
+    halDigitalWrite( _FSYNC, LOW );
+    writeFreq( 0, fw, ( _control & ( cB28 | cHLB ) ) | wave, true );
+    halDigitalWrite( _FSYNC, HIGH );
+    SpiBus::end();
+}
+
+
+//-----------------------------------------------------------------------------
+// loadFreqWord
+//    preload the 28 bit value into the FREQ register that is not in use
+//    the output is not affected until switchFreq() is called
+//    needs B28 set by a previous setFreqWord()
+//-----------------------------------------------------------------------------
+void AD9833::loadFreqWord( uint32_t fw ) {
+    SpiBus::begin();
+    halDigitalWrite( _FSYNC, LOW );
+    writeFreq( ( _control & cFselect ) ? 0 : 1, fw, _control, false );
+    halDigitalWrite( _FSYNC, HIGH );
+    SpiBus::end();
+}
+
+
+//-----------------------------------------------------------------------------
+// switchFreq
+//    toggle FSELECT to output the value preloaded by loadFreqWord()
+//    a single CONTROL word, phase continuous
+//-----------------------------------------------------------------------------
+void AD9833::switchFreq() {
+    _control ^= cFselect;
+    SpiBus::begin();
+    halDigitalWrite( _FSYNC, LOW );
+    write16( _control );
+    halDigitalWrite( _FSYNC, HIGH );
+    SpiBus::end();
+}
+
+
+//-----------------------------------------------------------------------------
+// phaseWord
+//    convert a phase in 0.1° into the 12 bit PHASE register value
+//    phase = round( tenths * 4096 / 3600 ), 0.088° resolution
+//-----------------------------------------------------------------------------
+uint16_t AD9833::phaseWord( uint16_t tenths ) {
+    return ( ( uint32_t( tenths % 3600 ) << 12 ) + 1800 ) / 3600; // < 4096
+}
+
+
+//-----------------------------------------------------------------------------
+// setPhaseWord
+//    set the 12 bit PHASE register reg ( 0 or 1 ), a single SPI word
+//    the phase is added to the phase accumulator when the register is
+//    selected by PSELECT, see selectControl()
+//    nothing is sent if the register holds the value already
+//-----------------------------------------------------------------------------
+void AD9833::setPhaseWord( uint8_t reg, uint16_t phase ) {
+    phase &= 0x0FFF;
+    if ( ( _phaseValid & ( 1 << reg ) ) && _phase[ reg ] == phase ) {
+        ++skipCount;
+        return;
+    }
+    SpiBus::begin();
+    halDigitalWrite( _FSYNC, LOW );
+    write16( ( reg ? aPhase1 : aPhase0 ) | phase );
+    halDigitalWrite( _FSYNC, HIGH );
+    SpiBus::end();
+    _phase[ reg ] = phase;
+    _phaseValid |= 1 << reg;
+}
+
+
+//-----------------------------------------------------------------------------
+// selectControl
+//    the current CONTROL word with FSELECT and PSELECT selecting
+//    FREQ register freqReg and PHASE register phaseReg ( 0 or 1 )
+//    precalculate the words for writeControl(), e.g. for FSK or PSK
+//-----------------------------------------------------------------------------
+uint16_t AD9833::selectControl( uint8_t freqReg, uint8_t phaseReg ) const {
+    uint16_t control = _control & ~( cFselect | cPselect );
+    if ( freqReg )
+        control |= cFselect;
+    if ( phaseReg )
+        control |= cPselect;
+    return control;
+}
+
+
+//-----------------------------------------------------------------------------
+// writeControl
+//    write a CONTROL word from selectControl(), a single SPI word
+//    called from the timer1 interrupt for each symbol,
+//    nothing is sent if the symbol does not change the register selection
+//-----------------------------------------------------------------------------
+void AD9833::writeControl( uint16_t control ) {
+    if ( control == _control ) {
+        ++skipCount;
+        return;
+    }
+    _control = control;
+    SpiBus::begin();
+    halDigitalWrite( _FSYNC, LOW );
+    write16( _control );
+    halDigitalWrite( _FSYNC, HIGH );
+    SpiBus::end();
+}
+
+
+//-----------------------------------------------------------------------------
+// writeFreq
+//    write the 28 bit value into FREQ register reg ( 0 or 1 )
+//    with partialUpdate only the 14 bit half that differs from the shadow
+//    is written with B28 = 0 and HLB selecting the half, i.e. one SPI word
+//    control: the CONTROL word to use, B28/HLB are adapted here,
+//    it is written only if it differs from the shadow _control
+//    select: the caller needs control ( waveform, FSELECT ), count it as skipped if not sent
+//    the caller handles SPI transaction and FSYNC
+//-----------------------------------------------------------------------------
+void AD9833::writeFreq( uint8_t reg, uint32_t fw, uint16_t control, bool select ) {
+    uint16_t addr = reg ? aFreq1 : aFreq0;
+    uint16_t lsb = uint16_t( fw & 0x3FFFL );
+    uint16_t msb = uint16_t( ( fw & 0xFFFC000L ) >> 14 );
+    bool sendLsb = true;
+    bool sendMsb = true;
+    if ( partialUpdate && ( _freqValid & ( 1 << reg ) ) ) {
+        sendLsb = lsb != uint16_t( _freq[ reg ] & 0x3FFFL );
+        sendMsb = msb != uint16_t( ( _freq[ reg ] & 0xFFFC000L ) >> 14 );
+    }
+    uint16_t ctrl = control;
+    if ( sendLsb && sendMsb ) // complete 28 bit write
+        ctrl = ( ctrl & ~cHLB ) | cB28;
+    else if ( sendLsb ) // 14 LSB only
+        ctrl &= ~( cB28 | cHLB );
+    else if ( sendMsb ) // 14 MSB only
+        ctrl = ( ctrl & ~cB28 ) | cHLB;
+    if ( ctrl != _control ) {
+        _control = ctrl;
+        write16( _control );
+    } else if ( select ) {
+        ++skipCount;
+    }
+    if ( sendLsb )
+        write16( lsb | addr );
+    else
+        ++skipCount;
+    if ( sendMsb )
+        write16( msb | addr );
+    else
+        ++skipCount;
+    _freq[ reg ] = fw;
+    _freqValid |= 1 << reg;
+}
+
+
+//-----------------------------------------------------------------------------
+// write16
+//    shift out one 16 bit word and count it
+//-----------------------------------------------------------------------------
+void AD9833::write16( uint16_t data ) {
+    halSpiTransfer16( data );
+    ++wordCount;
 }
 
 
@@ -11,12 +11,41 @@
 class AD9833 {
     private:
         const uint8_t _FSYNC;
+        uint16_t _control;   // shadow of the CONTROL word incl. B28, HLB, FSELECT
+        uint32_t _freq[ 2 ]; // shadow of FREQ0 and FREQ1
+        uint8_t _freqValid;  // bit 0: _freq[ 0 ] valid, bit 1: _freq[ 1 ] valid
+        uint16_t _phase[ 2 ]; // shadow of PHASE0 and PHASE1
+        uint8_t _phaseValid;  // bit 0: _phase[ 0 ] valid, bit 1: _phase[ 1 ] valid
+        void write16( uint16_t data );
+        void writeFreq( uint8_t reg, uint32_t fw, uint16_t control, bool select );
+        static const uint16_t cB28     = 0b0010000000000000;
+        static const uint16_t cHLB     = 0b0001000000000000;
+        static const uint16_t cFselect = 0b0000100000000000;
+        static const uint16_t cPselect = 0b0000010000000000;
+        static const uint16_t aFreq0   = 0b0100000000000000;
+        static const uint16_t aFreq1   = 0b1000000000000000;
+        static const uint16_t aPhase0  = 0b1100000000000000;
+        static const uint16_t aPhase1  = 0b1110000000000000;
 
     public:
         AD9833( uint8_t fsync = 10 );
         void reset();
         void setFrequency( long frequency, uint16_t wave );
+        void setFrequency( uint32_t hz, uint16_t milliHz, uint16_t wave );
+        void setFreqWord( uint32_t fw, uint16_t wave );
+        void loadFreqWord( uint32_t fw );
+        void switchFreq();
+        void setPhaseWord( uint8_t reg, uint16_t phase );
+        uint16_t selectControl( uint8_t freqReg, uint8_t phaseReg ) const;
+        void writeControl( uint16_t control );
+        static uint32_t freqWord( uint32_t hz, uint16_t milliHz = 0 );
+        static uint16_t phaseWord( uint16_t tenths );
+        static const uint32_t MCLK = 25000000; // master clock of the AD9833 board
+        bool partialUpdate = false; // write only the changed 14 bit half of a FREQ register
+        uint32_t wordCount = 0;     // number of 16 bit words sent
+        uint32_t skipCount = 0;     // number of 16 bit words not sent because the register holds the value
         static const uint16_t wReset     = 0b0000000100000000;
+        static const uint16_t wSleep     = 0b0000000011000000; // SLEEP1 | SLEEP12: MCLK and DAC off
         static const uint16_t wSine      = 0b0000000000000000;
         static const uint16_t wTriangle  = 0b0000000000000010;
         static const uint16_t wRectangle = 0b0000000000101000;
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    Button.cpp
+    Debounced push button with accelerating auto-repeat
+
+    update() is called periodically, e.g. every 5 ms, and never waits.
+    The pin must read the same level for DEBOUNCE samples to change the state.
+    A press returns true once, holding the button returns true again
+    after REPEATDELAY samples, then with an interval that shrinks
+    by 1/4 on every repeat down to REPEATMIN samples.
+*/
+
+#include "Button.h"
+#include "HAL.h"
+
+
+Button::Button( uint8_t pin ) : _pin( pin ), _pressed( false ), _count( 0 ), _hold( 0 ), _interval( 0 ) {}
+
+
+//-----------------------------------------------------------------------------
+// begin
+//   a button that is already pressed ( e.g. at power-on ) does not
+//   create events before it is released
+//-----------------------------------------------------------------------------
+void Button::begin() {
+    halPinMode( _pin, INPUT_PULLUP );
+    _pressed = halDigitalRead( _pin ) == LOW;
+    _count = 0;
+    _interval = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// update
+//   sample the pin, return true for a press or repeat event
+//-----------------------------------------------------------------------------
+bool Button::update() {
+    bool level = halDigitalRead( _pin ) == LOW;
+    if ( level != _pressed ) {
+        if ( ++_count < DEBOUNCE )
+            return false;
+        _count = 0;
+        _pressed = level;
+        if ( !_pressed ) // released
+            return false;
+        _hold = REPEATDELAY;
+        _interval = REPEATSTART;
+        return true;
+    }
+    _count = 0;
+    if ( !_pressed || !_interval || --_hold )
+        return false;
+    _hold = _interval; // repeat
+    _interval -= _interval / 4;
+    if ( _interval < REPEATMIN )
+        _interval = REPEATMIN;
+    return true;
+}
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  Button.h
+//    Debounced push button with accelerating auto-repeat
+//    active low, uses the internal pull-up
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+class Button {
+    private:
+        const uint8_t _pin;
+        bool _pressed;      // debounced state
+        uint8_t _count;     // samples that differ from _pressed
+        uint8_t _hold;      // samples until the next repeat
+        uint8_t _interval;  // current repeat interval, 0: no repeat until released
+
+    public:
+        // all times in samples, i.e. calls of update()
+        static const uint8_t DEBOUNCE = 4;     // equal samples for a state change
+        static const uint8_t REPEATDELAY = 100; // hold time until the first repeat
+        static const uint8_t REPEATSTART = 40;  // first repeat interval
+        static const uint8_t REPEATMIN = 8;     // fastest repeat interval
+
+        explicit Button( uint8_t pin );
+        void begin();
+        bool update();
+        bool pressed() const { return _pressed; }
+};
@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    HAL.cpp
+    Hardware abstraction for the ATmega328
+
+    Timer1: CTC mode, prescaler 64 ( 4 µs at 16 MHz ), compare match interrupt
+            compare match B moves through the tick period as symbol clock
+    Pin change interrupt 2: external input D2 ( PD2 )
+    Timer2: phase correct PWM on OC2B ( pin 3 )
+    SPI, Serial and the digital pins: Arduino API
+*/
+
+#include "HAL.h"
+#include <SPI.h>
+
+
+static void ( *tickHandler )() = 0;
+static volatile uint32_t tickCount = 0;
+
+static const uint8_t tickPrescaler = 64;
+
+static void ( *symbolHandler )() = 0;
+static uint16_t symbolCycles = 0;        // whole ticks per symbol
+static uint16_t symbolRest = 0;          // remaining timer counts per symbol
+static uint8_t symbolFraction = 0;       // 1/256 timer counts per symbol
+static uint8_t symbolSum = 0;            // accumulated fractions
+static volatile uint16_t symbolSkip = 0; // compare matches to ignore until the next symbol
+
+static void ( *pinChangeHandler )() = 0;
+
+
+//-----------------------------------------------------------------------------
+// halInitTick
+//   call handler rate times per second from the timer1 compare match interrupt
+//   the timer counts 0..OCR1A, i.e. OCR1A + 1 counts per tick
+//-----------------------------------------------------------------------------
+void halInitTick( uint16_t rate, void ( *handler )() ) {
+    uint16_t top = F_CPU / tickPrescaler / rate - 1;
+    tickHandler = handler;
+    TCCR1A = 0x00; // no output on compare match
+    TCCR1B = 0x0B; // CTCmode, prescaler = 64 -> 250kHz
+    TCCR1C = 0x00; // no pwm output
+    OCR1AH = highByte( top );
+    OCR1AL = lowByte( top );
+    OCR1BH = 0;
+    OCR1BL = 0;
+
+    TCNT1H = 0;   // must be written first
+    TCNT1L = 0;   // clear the counter
+    TIFR1 = 0xFF; // clear all flags
+    TIMSK1 = _BV( OCIE1A ); // compare match interrupt
+}
+
+
+uint16_t halTickPhase() { return TCNT1; }
+
+
+uint16_t halTickPeriod() { return OCR1A + 1; }
+
+
+uint16_t halTickMicros( uint16_t counts ) { return uint32_t( counts ) * tickPrescaler / ( F_CPU / 1000000L ); }
+
+
+//-----------------------------------------------------------------------------
+// halMicros
+//   ticks and timer counts since halInitTick() in µs, resolution 4 µs
+//   a compare match that is not yet handled ( interrupts blocked ) is counted
+//-----------------------------------------------------------------------------
+unsigned long halMicros() {
+    const uint8_t sreg = SREG;
+    noInterrupts();
+    const uint16_t phase = TCNT1;
+    uint32_t ticks = tickCount;
+    if ( ( TIFR1 & _BV( OCF1A ) ) && phase < ( OCR1A >> 1 ) ) // timer restarted, interrupt pending
+        ++ticks;
+    SREG = sreg;
+    return ( ticks * ( OCR1A + 1 ) + phase ) * ( tickPrescaler / ( F_CPU / 1000000L ) );
+}
+
+
+ISR( TIMER1_COMPA_vect ) {
+    ++tickCount;
+    if ( tickHandler )
+        tickHandler();
+}
+
+
+//-----------------------------------------------------------------------------
+// halStartSymbols
+//   call handler rate + milliHz / 1000 times per second ( rate >= 1 )
+//   from the timer1 compare match B interrupt
+//   the symbol period is split into whole ticks ( OCR1A + 1 counts ), timer counts
+//   and 1/256 counts, OCR1B is advanced by the counts and the fraction carry
+//   after each symbol, the compare matches of the whole ticks are skipped
+//   the first symbol follows after 32 µs
+//-----------------------------------------------------------------------------
+void halStartSymbols( uint16_t rate, void ( *handler )(), uint16_t milliHz ) {
+    const uint16_t top = OCR1A + 1;
+    // counts << 8 = ( F_CPU / prescaler << 8 ) * 1000 / rate in mHz, decimal long division in 32 bit
+    const uint32_t rateMilli = uint32_t( rate ) * 1000 + milliHz;
+    const uint32_t counts = uint32_t( F_CPU / tickPrescaler ) << 8;
+    uint32_t period = counts / rateMilli;
+    uint32_t rem = counts % rateMilli;
+    for ( uint8_t digit = 0; digit < 3; ++digit ) {
+        rem *= 10;
+        period = period * 10 + rem / rateMilli;
+        rem %= rateMilli;
+    }
+    const uint8_t sreg = SREG;
+    noInterrupts();
+    symbolHandler = handler;
+    symbolCycles = ( period >> 8 ) / top;
+    symbolRest = ( period >> 8 ) % top;
+    symbolFraction = lowByte( period );
+    symbolSum = 0;
+    symbolSkip = 0;
+    uint16_t first = TCNT1 + 8;
+    if ( first >= top )
+        first -= top;
+    OCR1B = first;
+    TIFR1 = _BV( OCF1B ); // clear a stale match
+    TIMSK1 |= _BV( OCIE1B );
+    SREG = sreg;
+}
+
+
+void halStopSymbols() {
+    TIMSK1 &= ~_BV( OCIE1B );
+    symbolHandler = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// compare match B: next symbol or skip one tick of a long symbol
+//   a match at a position before the current one happens in the next tick
+//   if the interrupt ran late and the counter passed the new match already,
+//   the timer would find it one tick later: the symbol is handled at once
+//-----------------------------------------------------------------------------
+ISR( TIMER1_COMPB_vect ) {
+    if ( symbolSkip ) {
+        --symbolSkip;
+        return;
+    }
+    const uint16_t top = OCR1A + 1;
+    for ( ;; ) {
+        if ( symbolHandler )
+            symbolHandler();
+        const uint16_t now = OCR1B;
+        uint16_t next = now + symbolRest;
+        uint16_t cycles = symbolCycles;
+        symbolSum += symbolFraction;
+        if ( symbolSum < symbolFraction ) // carry
+            ++next;
+        if ( next >= top ) {
+            next -= top;
+            ++cycles;
+        }
+        symbolSkip = ( cycles && next <= now ) ? cycles - 1 : cycles;
+        OCR1B = next;
+        if ( symbolSkip )
+            return;
+        const uint16_t due = next > now ? next - now : next + top - now; // counts from the last match
+        uint16_t passed = TCNT1;
+        passed = passed >= now ? passed - now : passed + top - now;
+        if ( passed <= due ) // TCNT1 == next still sets the flag
+            return;
+        TIFR1 = _BV( OCF1B ); // a match of the old value must not repeat the symbol
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// halStartPinChange
+//   call handler for each edge of the external input D2
+//   the buttons D5..D7 share the interrupt but are not enabled in PCMSK2
+//-----------------------------------------------------------------------------
+void halStartPinChange( void ( *handler )() ) {
+    const uint8_t sreg = SREG;
+    noInterrupts();
+    pinChangeHandler = handler;
+    PCMSK2 |= _BV( PCINT18 );
+    PCIFR = _BV( PCIF2 ); // clear an old edge
+    PCICR |= _BV( PCIE2 );
+    SREG = sreg;
+}
+
+
+void halStopPinChange() {
+    PCMSK2 &= ~_BV( PCINT18 );
+    pinChangeHandler = 0;
+}
+
+
+bool halExtInput() { return PIND & _BV( PIND2 ); }
+
+
+ISR( PCINT2_vect ) {
+    if ( pinChangeHandler )
+        pinChangeHandler();
+}
+
+
+//-----------------------------------------------------------------------------
+// halInitChargePump
+//   output 50 kHz rectangle at D3 for a charge pump to create -5V for an op-amp
+//-----------------------------------------------------------------------------
+void halInitChargePump( uint8_t pin ) {
+    // Initialize Timer2
+    TCCR2A = 0;
+    TCCR2B = 0;
+    TCNT2 = 0;
+
+    // Set OC2B for Compare Match (digital pin3)
+    pinMode( pin, OUTPUT );
+
+    bitSet( TCCR2A, COM2B1 ); // clear OC2B on up count compare match
+
+    // Set mode 5 -> Phase correct PWM to OCR2A counts up and down
+    bitSet( TCCR2A, WGM20 );
+    bitSet( TCCR2B, WGM22 );
+
+    // Set up prescaler to 001 = clk (16 MHz)
+    bitSet( TCCR2B, CS20 );
+
+    OCR2A = 160; // Sets t = 10 µs up + 10 µs down -> freq = 50 kHz
+    OCR2B = 80;  // 50% duty cycle, valid values: 0 (permanent low), 1..159, 160 (permanent high)
+}
+
+
+//-----------------------------------------------------------------------------
+// SPI
+//   with usingInterrupt( 255 ) beginTransaction() blocks all interrupts,
+//   so the interrupt handlers can use the bus without a transaction of their own
+//-----------------------------------------------------------------------------
+void halSpiBegin() {
+    SPI.begin();
+    SPI.usingInterrupt( 255 );
+}
+
+
+void halSpiBeginTransaction() { SPI.beginTransaction( SPISettings( 10000000, MSBFIRST, SPI_MODE3 ) ); }
+
+
+void halSpiEndTransaction() { SPI.endTransaction(); }
+
+
+uint8_t halSpiTransfer( uint8_t data ) { return SPI.transfer( data ); }
+
+
+uint16_t halSpiTransfer16( uint16_t data ) { return SPI.transfer16( data ); }
+
+
+//-----------------------------------------------------------------------------
+// serial port and digital pins
+//-----------------------------------------------------------------------------
+Stream &halSerial = Serial;
+
+
+void halSerialBegin( unsigned long baud ) { Serial.begin( baud ); }
+
+
+void halPinMode( uint8_t pin, uint8_t mode ) { pinMode( pin, mode ); }
+
+
+void halDigitalWrite( uint8_t pin, uint8_t level ) { digitalWrite( pin, level ); }
+
+
+int halDigitalRead( uint8_t pin ) { return digitalRead( pin ); }
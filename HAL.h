@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  HAL.h
+//    Hardware abstraction: AVR timers, SPI, serial port and digital pins
+//    the firmware reaches the hardware only through this interface
+//    and TwiQueue for I2C, so a port or the host build ( see host/ )
+//    replaces only HAL.cpp, TwiQueue.cpp and the Arduino core
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+// periodic tick, handler is called from the interrupt
+void halInitTick( uint16_t rate, void ( *handler )() );
+uint16_t halTickPhase();  // timer counts since the last tick
+uint16_t halTickPeriod(); // timer counts per tick
+uint16_t halTickMicros( uint16_t counts ); // convert timer counts to µs
+unsigned long halMicros(); // µs since halInitTick(), like micros() but from the tick timer
+
+// symbol clock independent of the tick, handler is called rate + milliHz / 1000 times per second
+// from the interrupt, average rate exact, jitter 4 µs plus the interrupt latency,
+// a symbol whose match passed during a late interrupt follows at once, needs halInitTick()
+void halStartSymbols( uint16_t rate, void ( *handler )(), uint16_t milliHz = 0 );
+void halStopSymbols();
+
+// external input D2 ( PCINT18 ), handler is called from the pin change interrupt on both edges
+void halStartPinChange( void ( *handler )() );
+void halStopPinChange();
+bool halExtInput(); // level of the external input
+
+// 50 kHz rectangle for the charge pump of the neg. supply, pin must be 3 ( OC2B )
+void halInitChargePump( uint8_t pin );
+
+// SPI bus, mode 3, MSB first, F_CPU / 2
+// a transaction blocks all interrupts until its end
+void halSpiBegin();
+void halSpiBeginTransaction();
+void halSpiEndTransaction();
+uint8_t halSpiTransfer( uint8_t data );
+uint16_t halSpiTransfer16( uint16_t data );
+
+// serial port, Serial on the board
+extern Stream &halSerial;
+void halSerialBegin( unsigned long baud );
+
+// digital pins, like pinMode(), digitalWrite() and digitalRead()
+void halPinMode( uint8_t pin, uint8_t mode );
+void halDigitalWrite( uint8_t pin, uint8_t level );
+int halDigitalRead( uint8_t pin );
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    HopTable.cpp
+    List of frequencies with dwell times
+
+    The entries hold the final register values, computed when they are added.
+    tick() is called from the timer interrupt and returns the entry
+    that must be written now, so the dwell times do not depend on the main loop.
+*/
+
+#include "HopTable.h"
+
+
+HopTable::HopTable() : _count( 0 ), _index( 0 ), _remaining( 0 ), _loop( false ), _playing( false ) {}
+
+
+//-----------------------------------------------------------------------------
+// add
+//   append an entry, returns false if the table is full
+//   dwell = 0 is handled as 1 tick
+//-----------------------------------------------------------------------------
+bool HopTable::add( uint32_t fw, uint16_t dwell, uint8_t flags, uint8_t pot ) {
+    if ( _count >= SIZE )
+        return false;
+    Entry &e = _entries[ _count ];
+    e.fw = fw;
+    e.dwell = dwell ? dwell : 1;
+    e.pot = pot;
+    e.flags = flags;
+    ++_count; // complete before the interrupt can see it
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// clear
+//   stop and remove all entries
+//-----------------------------------------------------------------------------
+void HopTable::clear() {
+    _playing = false;
+    _count = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// play
+//   start with the first entry at the next tick
+//   loop = false: stop after the dwell time of the last entry
+//-----------------------------------------------------------------------------
+void HopTable::play( bool loop ) {
+    _playing = false;
+    if ( !_count )
+        return;
+    _loop = loop;
+    _index = 0xFF; // next is entry 0
+    _remaining = 1;
+    _playing = true;
+}
+
+
+//-----------------------------------------------------------------------------
+// trigger
+//   play once, return the first entry that must be written now,
+//   its dwell time counts from the next tick on
+//-----------------------------------------------------------------------------
+const HopTable::Entry *HopTable::trigger() {
+    _playing = false;
+    if ( !_count )
+        return 0;
+    _loop = false;
+    _index = 0;
+    _remaining = _entries[ 0 ].dwell;
+    _playing = true;
+    return &_entries[ 0 ];
+}
+
+
+//-----------------------------------------------------------------------------
+// tick
+//   count down the dwell time, return the next entry or 0
+//-----------------------------------------------------------------------------
+const HopTable::Entry *HopTable::tick() {
+    if ( !_playing || --_remaining )
+        return 0;
+    if ( ++_index >= _count ) {
+        if ( !_loop ) {
+            _playing = false;
+            return 0;
+        }
+        _index = 0;
+    }
+    _remaining = _entries[ _index ].dwell;
+    return &_entries[ _index ];
+}
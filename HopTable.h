@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  HopTable.h
+//    List of frequencies with dwell times
+//    played back from a timer interrupt
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+class HopTable {
+    public:
+        struct Entry {
+            uint32_t fw;    // AD9833 FREQ register value
+            uint16_t dwell; // ticks
+            uint8_t pot;    // MCP41010 value if flags & fLevel
+            uint8_t flags;
+        };
+        static const uint8_t SIZE = 16;
+        static const uint8_t fLevel = 0x01; // write pot
+        static const uint8_t fOff = 0x02;   // shut down pot
+
+        HopTable();
+        bool add( uint32_t fw, uint16_t dwell, uint8_t flags = 0, uint8_t pot = 0 );
+        void clear();
+        uint8_t count() const { return _count; }
+        void play( bool loop );
+        const Entry *trigger(); // play once, call from an interrupt
+        void stop() { _playing = false; }
+        bool playing() const { return _playing; }
+        const Entry *tick(); // call from the timer interrupt
+
+    private:
+        Entry _entries[ SIZE ];
+        uint8_t _count;
+        // set by play() and trigger() before _playing, read by the interrupt
+        volatile uint8_t _index;      // entry in output
+        volatile uint16_t _remaining; // ticks until the next entry
+        volatile bool _loop;
+        volatile bool _playing;
+};
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  LevelTables.h
+//    Level tables of the MCP41010 digital pot in 0.1 dB
+//    relative to full scale ( pot value 255 )
+//    generated by tools/levels.py, do not edit
+//
+//******************************************
+
+#pragma once
+
+#include <avr/pgmspace.h>
+
+// pot value -> level: round( 200 * log10( ( value + 1 ) / 256 ) )
+const int16_t potTodB10[ 256 ] PROGMEM = {
+    -482, -421, -386, -361, -342, -326, -313, -301, -291, -282, -273, -266, -259, -252, -246, -241,
+    -236, -231, -226, -221, -217, -213, -209, -206, -202, -199, -195, -192, -189, -186, -183, -181,
+    -178, -175, -173, -170, -168, -166, -163, -161, -159, -157, -155, -153, -151, -149, -147, -145,
+    -144, -142, -140, -138, -137, -135, -134, -132, -130, -129, -127, -126, -125, -123, -122, -120,
+    -119, -118, -116, -115, -114, -113, -111, -110, -109, -108, -107, -105, -104, -103, -102, -101,
+    -100, -99, -98, -97, -96, -95, -94, -93, -92, -91, -90, -89, -88, -87, -86, -85,
+    -84, -83, -83, -82, -81, -80, -79, -78, -77, -77, -76, -75, -74, -73, -73, -72,
+    -71, -70, -70, -69, -68, -67, -67, -66, -65, -64, -64, -63, -62, -62, -61, -60,
+    -60, -59, -58, -58, -57, -56, -56, -55, -54, -54, -53, -52, -52, -51, -51, -50,
+    -49, -49, -48, -48, -47, -46, -46, -45, -45, -44, -44, -43, -42, -42, -41, -41,
+    -40, -40, -39, -39, -38, -38, -37, -37, -36, -36, -35, -35, -34, -34, -33, -33,
+    -32, -32, -31, -31, -30, -30, -29, -29, -28, -28, -27, -27, -26, -26, -25, -25,
+    -25, -24, -24, -23, -23, -22, -22, -21, -21, -21, -20, -20, -19, -19, -18, -18,
+    -18, -17, -17, -16, -16, -16, -15, -15, -14, -14, -14, -13, -13, -12, -12, -12,
+    -11, -11, -10, -10, -10, -9, -9, -9, -8, -8, -7, -7, -7, -6, -6, -6,
+    -5, -5, -5, -4, -4, -3, -3, -3, -2, -2, -2, -1, -1, -1, 0, 0,
+};
+
+// level i * 0.1 dB below full scale -> pot value: round( 256 * 10^( -i / 200 ) ) - 1
+// lower levels are off
+const uint16_t dB10Range = 542;
+const uint8_t dB10ToPot[ dB10Range ] PROGMEM = {
+    255, 252, 249, 246, 243, 241, 238, 235, 232, 230, 227, 225, 222, 219, 217, 214, 212, 209, 207, 205,
+    202, 200, 198, 195, 193, 191, 189, 187, 184, 182, 180, 178, 176, 174, 172, 170, 168, 166, 164, 162,
+    161, 159, 157, 155, 153, 151, 150, 148, 146, 145, 143, 141, 140, 138, 136, 135, 133, 132, 130, 129,
+    127, 126, 124, 123, 122, 120, 119, 117, 116, 115, 113, 112, 111, 109, 108, 107, 106, 104, 103, 102,
+    101, 100, 99, 97, 96, 95, 94, 93, 92, 91, 90, 89, 88, 87, 86, 85, 84, 83, 82, 81,
+    80, 79, 78, 77, 76, 75, 75, 74, 73, 72, 71, 70, 70, 69, 68, 67, 66, 66, 65, 64,
+    63, 63, 62, 61, 60, 60, 59, 58, 58, 57, 56, 56, 55, 54, 54, 53, 52, 52, 51, 51,
+    50, 49, 49, 48, 48, 47, 47, 46, 46, 45, 45, 44, 43, 43, 42, 42, 41, 41, 41, 40,
+    40, 39, 39, 38, 38, 37, 37, 36, 36, 36, 35, 35, 34, 34, 34, 33, 33, 32, 32, 32,
+    31, 31, 30, 30, 30, 29, 29, 29, 28, 28, 28, 27, 27, 27, 26, 26, 26, 25, 25, 25,
+    25, 24, 24, 24, 23, 23, 23, 23, 22, 22, 22, 22, 21, 21, 21, 21, 20, 20, 20, 20,
+    19, 19, 19, 19, 18, 18, 18, 18, 18, 17, 17, 17, 17, 17, 16, 16, 16, 16, 16, 15,
+    15, 15, 15, 15, 14, 14, 14, 14, 14, 14, 13, 13, 13, 13, 13, 13, 12, 12, 12, 12,
+    12, 12, 12, 11, 11, 11, 11, 11, 11, 11, 10, 10, 10, 10, 10, 10, 10, 10, 9, 9,
+    9, 9, 9, 9, 9, 9, 9, 8, 8, 8, 8, 8, 8, 8, 8, 8, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0,
+};
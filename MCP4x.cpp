@@ -5,47 +5,58 @@
 */
 
 #include "MCP4x.h"
-#include <SPI.h>
+#include "HAL.h"
+#include "SpiBus.h"
 #include <math.h>
 
 
-MCP4x::MCP4x( uint8_t cs  ) : _cs( cs ) {}
+MCP4x::MCP4x( uint8_t cs  ) : _cs( cs ), _command( 0 ), _data( 0 ) {}
 
 
 void MCP4x::begin( void ) {
     // setup SPI
-    SPI.begin();
+    halSpiBegin();
     // define MCP /CS line
-    digitalWrite( _cs, HIGH );
-    pinMode( _cs, OUTPUT );
+    halDigitalWrite( _cs, HIGH );
+    halPinMode( _cs, OUTPUT );
 }
 
 
 void MCP4x::setPot( uint8_t value ) {
-    // select device
-    digitalWrite( _cs, LOW );
+    write( 0x11, value );
+}
 
-    // init SPI transfer
-    SPI.beginTransaction( SPISettings( 10000000, MSBFIRST, SPI_MODE0 ) );
-    SPI.transfer( 0x11 );  // shift out command
-    SPI.transfer( value ); // shift out data
-    SPI.endTransaction();  // release SPI
 
-    // deselect device
-    digitalWrite( _cs,  HIGH );
+void MCP4x::shutdown() {
+    write( 0x21, 0 );
 }
 
 
-void MCP4x::shutdown() {
-    // select device
-    digitalWrite( _cs, LOW );
+//-----------------------------------------------------------------------------
+// write
+//   send a command with data byte unless it repeats the last one
+//   the MCP41010 supports SPI mode 0 and 3, mode 3 is shared with the AD9833
+//   the shadow is compared and updated within the SPI transaction,
+//   it blocks the interrupts, so writeHop() in an ISR cannot change it meanwhile
+//-----------------------------------------------------------------------------
+void MCP4x::write( uint8_t command, uint8_t data ) {
+    SpiBus::begin();
+    if ( command == _command && data == _data ) {
+        ++skipCount;
+        SpiBus::end();
+        return;
+    }
 
-    // init SPI transfer
-    SPI.beginTransaction( SPISettings( 10000000, MSBFIRST, SPI_MODE0 ) );
-    SPI.transfer( 0x21 );  // shift out command
-    SPI.transfer( 0 ); // shift out data
-    SPI.endTransaction();  // release SPI
+    // select device
+    halDigitalWrite( _cs, LOW );
+    halSpiTransfer( command ); // shift out command
+    halSpiTransfer( data );    // shift out data
 
     // deselect device
-    digitalWrite( _cs,  HIGH );
+    halDigitalWrite( _cs,  HIGH );
+
+    _command = command;
+    _data = data;
+    ++writeCount;
+    SpiBus::end(); // release SPI
 }
@@ -12,10 +12,16 @@
 class MCP4x {
     private:
         const uint8_t _cs;
+        uint8_t _command; // shadow of the last command, 0: unknown
+        uint8_t _data;
+        void write( uint8_t command, uint8_t data );
 
     public:
         MCP4x( uint8_t cs );
         void begin( void );
         void setPot( uint8_t value );
         void shutdown();
+        int16_t value() const { return _command == 0x11 ? _data : -1; } // -1: shut down or not set
+        uint32_t writeCount = 0; // number of 16 bit commands sent
+        uint32_t skipCount = 0;  // number of commands not sent because nothing changes
 };
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    Modulator.cpp
+    FSK / PSK symbol source, bursts
+
+    The CONTROL words for both symbols are calculated before the start,
+    symbol() only selects one of them, so the interrupt writes a single
+    SPI word per symbol ( FSELECT or PSELECT toggled, output on or off ).
+    PRBS-9: x^9 + x^5 + 1, 511 bits, as used for bit error rate tests.
+*/
+
+#include "Modulator.h"
+
+
+Modulator::Modulator() : _pattern( 0b10 ), _length( 2 ), _bit( 0 ), _lfsr( 0x1FF ), _on( 0 ), _period( 0 ),
+                         _phase( 0 ), _running( false ) {
+    _control[ 0 ] = 0;
+    _control[ 1 ] = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// setPattern
+//   send the length LSBs of pattern MSB first and repeat them
+//   length = PRBS: PRBS-9 sequence, length > BITS is limited to BITS
+//-----------------------------------------------------------------------------
+void Modulator::setPattern( uint16_t pattern, uint8_t length ) {
+    const bool running = _running;
+    _running = false;
+    _pattern = pattern;
+    _length = length > BITS ? BITS : length;
+    _bit = 0;
+    _lfsr = 0x1FF;
+    _running = running;
+}
+
+
+//-----------------------------------------------------------------------------
+// start
+//   output the pattern from its beginning with the CONTROL words
+//   control0 for bit 0 and control1 for bit 1
+//-----------------------------------------------------------------------------
+void Modulator::start( uint16_t control0, uint16_t control1 ) {
+    _running = false;
+    _control[ 0 ] = control0;
+    _control[ 1 ] = control1;
+    _bit = 0;
+    _lfsr = 0x1FF;
+    _period = 0;
+    _running = true;
+}
+
+
+//-----------------------------------------------------------------------------
+// startBurst
+//   repeat on symbols 1 ( control1 ) and off symbols 0 ( control0 ),
+//   starting with the 1 symbols, on + off must be < 65536
+//-----------------------------------------------------------------------------
+void Modulator::startBurst( uint16_t control0, uint16_t control1, uint16_t on, uint16_t off ) {
+    _running = false;
+    _control[ 0 ] = control0;
+    _control[ 1 ] = control1;
+    _on = on;
+    _period = on + off;
+    _phase = 0;
+    _running = true;
+}
+
+
+//-----------------------------------------------------------------------------
+// symbol
+//   the CONTROL word of the next bit
+//-----------------------------------------------------------------------------
+uint16_t Modulator::symbol() {
+    uint8_t bit;
+    if ( _period ) {
+        bit = _phase < _on;
+        if ( ++_phase >= _period )
+            _phase = 0;
+    } else if ( _length == PRBS ) {
+        bit = ( ( _lfsr >> 8 ) ^ ( _lfsr >> 4 ) ) & 1;
+        _lfsr = ( ( _lfsr << 1 ) | bit ) & 0x1FF;
+    } else {
+        bit = ( _pattern >> ( _length - 1 - _bit ) ) & 1;
+        if ( ++_bit >= _length )
+            _bit = 0;
+    }
+    return _control[ bit ];
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  Modulator.h
+//    FSK / PSK symbol source, a repeated bit pattern or PRBS-9,
+//    or bursts: a number of 1 symbols followed by a number of 0 symbols
+//    each bit selects one of two precalculated AD9833 CONTROL words
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+class Modulator {
+    public:
+        static const uint8_t BITS = 16; // max. pattern length
+        static const uint8_t PRBS = 0;  // pattern length for the PRBS-9 sequence
+
+        Modulator();
+        void setPattern( uint16_t pattern, uint8_t length );
+        void start( uint16_t control0, uint16_t control1 );
+        void startBurst( uint16_t control0, uint16_t control1, uint16_t on, uint16_t off );
+        void stop() { _running = false; }
+        bool running() const { return _running; }
+        uint16_t symbol(); // call from the symbol interrupt
+        uint16_t control( bool bit ) const { return _control[ bit ]; }
+
+    private:
+        uint16_t _control[ 2 ]; // CONTROL word for bit 0 and bit 1
+        uint16_t _pattern;
+        uint8_t _length; // bits of _pattern, PRBS: pseudo random
+        uint8_t _bit;    // next bit, MSB first
+        uint16_t _lfsr;  // PRBS-9 shift register
+        uint16_t _on;     // burst: 1 symbols per period
+        uint16_t _period; // burst: symbols per period, 0: pattern
+        uint16_t _phase;  // burst: symbols since the start of the period
+        volatile bool _running;
+};
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    Scheduler.cpp
+    Cooperative task scheduler
+
+    The timer interrupt only counts ticks, run() waits for the next tick
+    and calls all tasks that are due, each runs to completion.
+    A task that is due again before it ran ( i.e. it missed one or more periods )
+    or that runs longer than its deadline counts an overrun,
+    the missed periods are skipped, not caught up.
+    The run times are measured with the clock given to the constructor
+    and kept as max per task, with SCHEDULER_STATS also as min / mean
+    and a coarse histogram. The 16 bit counters saturate.
+*/
+
+#include "Scheduler.h"
+
+
+Scheduler::Scheduler( Clock clock ) : _count( 0 ), _clock( clock ), _ticks( 0 ), _now( 0 ) {}
+
+
+//-----------------------------------------------------------------------------
+// add
+//   append a task that is called every period ticks
+//   name must point to PROGMEM, e.g. PSTR( "sweep" )
+//-----------------------------------------------------------------------------
+bool Scheduler::add( Function function, const char *name, uint16_t period, uint16_t deadline ) {
+    if ( _count >= MAXTASKS )
+        return false;
+    Task &t = _tasks[ _count++ ];
+    t.function = function;
+    t.name = name;
+    t.period = period ? period : 1;
+    t.deadline = deadline;
+    t.due = _now + 1;
+    clearStats( t );
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// run
+//   wait for the next tick and call the due tasks
+//   call it from loop()
+//-----------------------------------------------------------------------------
+void Scheduler::run() {
+    uint16_t now;
+    do {
+        noInterrupts(); // 16 bit read
+        now = _ticks;
+        interrupts();
+    } while ( now == _now );
+    missed += uint16_t( now - _now - 1 );
+    _now = now;
+    for ( uint8_t i = 0; i < _count; ++i ) {
+        Task &t = _tasks[ i ];
+        if ( int16_t( now - t.due ) < 0 )
+            continue;
+        bool overrun = false;
+        if ( uint16_t( now - t.due ) >= t.period ) { // missed at least one period
+            overrun = true;
+            t.due = now;
+        }
+        t.due += t.period;
+        uint32_t start = _clock();
+        t.function();
+        uint32_t duration = _clock() - start;
+        if ( duration > 0xFFFF )
+            duration = 0xFFFF;
+        if ( duration > t.worst )
+            t.worst = duration;
+#if SCHEDULER_STATS
+        if ( duration < t.best )
+            t.best = duration;
+        t.total += duration;
+        uint8_t bin = 0;
+        for ( uint16_t d = duration >> 4; d && bin < BINS - 1; d >>= 2 )
+            ++bin;
+        if ( t.histogram[ bin ] < 0xFFFF )
+            ++t.histogram[ bin ];
+#endif
+        if ( duration > t.deadline )
+            overrun = true;
+        if ( overrun && t.overruns < 0xFFFF )
+            ++t.overruns;
+        if ( t.runs < 0xFFFF )
+            ++t.runs;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// clearStats
+//   reset the overrun and duration counters of all tasks and the missed ticks
+//-----------------------------------------------------------------------------
+void Scheduler::clearStats() {
+    for ( uint8_t i = 0; i < _count; ++i )
+        clearStats( _tasks[ i ] );
+    missed = 0;
+}
+
+
+void Scheduler::clearStats( Task &t ) {
+    t.overruns = 0;
+    t.worst = 0;
+    t.runs = 0;
+#if SCHEDULER_STATS
+    t.best = 0xFFFF;
+    t.total = 0;
+    for ( uint8_t i = 0; i < BINS; ++i )
+        t.histogram[ i ] = 0;
+#endif
+}
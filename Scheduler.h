@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  Scheduler.h
+//    Cooperative task scheduler
+//    driven by a periodic tick, e.g. from a timer interrupt
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef SCHEDULER_STATS
+#define SCHEDULER_STATS 0 // 1: min / mean and histogram of the run times, 20 more bytes per task
+#endif
+
+class Scheduler {
+    public:
+        typedef void ( *Function )();
+        typedef unsigned long ( *Clock )(); // µs, e.g. micros()
+        static const uint8_t BINS = 6; // duration histogram: < 16, 64, 256, 1024, 4096 µs, longer
+        struct Task { // 16 bytes on AVR, counters saturate
+            Function function;
+            const char *name;  // PROGMEM
+            uint16_t period;   // ticks between two runs
+            uint16_t deadline; // µs, max. duration of one run
+            uint16_t due;      // tick of the next run
+            uint16_t overruns; // runs that started a period late or exceeded the deadline
+            uint16_t worst;    // µs, longest run
+            uint16_t runs;
+#if SCHEDULER_STATS
+            uint16_t best;     // µs, shortest run
+            uint32_t total;    // µs, sum of all runs
+            uint16_t histogram[ BINS ];
+#endif
+        };
+        static const uint8_t MAXTASKS = 6;
+
+        explicit Scheduler( Clock clock = micros );
+        bool add( Function function, const char *name, uint16_t period, uint16_t deadline );
+        void tick() { ++_ticks; } // call from the timer interrupt
+        void run();
+        void clearStats();
+        uint8_t count() const { return _count; }
+        const Task &task( uint8_t i ) const { return _tasks[ i ]; }
+        uint16_t missed = 0; // ticks without a run() call
+
+    private:
+        Task _tasks[ MAXTASKS ]; // run in this order when due in the same tick
+        uint8_t _count;
+        Clock _clock;
+        volatile uint16_t _ticks; // incremented by tick()
+        uint16_t _now;            // tick handled by run()
+        static void clearStats( Task &t );
+};
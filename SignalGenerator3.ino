@@ -11,6 +11,31 @@
 //   subject to the GNU General Public License
 //
 // Changelog:
+// 20261016:    integer sweep engine, no float math in the sweep step
+// 20261016:    sweep steps switch between preloaded FREQ0/FREQ1 registers
+// 20261016:    write only the changed 14 bit half of the FREQ registers
+// 20261016:    exact integer FREQ register calculation, accept fractional Hz, e.g. 1000.25
+// 20261016:    OLED framebuffer, send only changed display bytes
+// 20261016:    interrupt driven I2C, drawing does not stall the sweep
+// 20261016:    cooperative task scheduler on timer1 interrupt with overrun statistics
+// 20261016:    non-blocking button debounce, accelerating auto-repeat when held
+// 20261016:    115200 baud, handle all received bytes per tick, binary command frames
+// 20261016:    frequency hop table with dwell times, played from timer1 interrupt
+// 20261016:    custom sweep profiles: duration, steps, lin/log, up/down/triangle, sync on testOut
+// 20261016:    timer access moved into HAL, exact 1 ms tick ( was 1.004 ms )
+// 20261016:    SPI, serial port and pins through HAL, host build with mock backends in host/
+// 20261016:    benchmark of redraw, sweep step and command handling on the host build, see host/bench.cpp
+// 20261016:    'L' task timing from timer1: min / mean / max, histogram, missed ticks
+// 20261016:    redraw only the changed parts of the menu ( widgets )
+// 20261016:    level tables in 0.1 dB generated by tools/levels.py, no float math
+// 20261016:    frequency dependent level calibration, applied to every output change
+// 20261016:    binary frequencies with cached FREQ words instead of digit arrays, up to 12.5 MHz
+// 20261016:    shadow registers skip unchanged SPI writes, one SPI transaction per tick
+// 20261016:    EEPROM presets with wear levelling, last state output at power-on before the display init
+// 20261016:    FSK / PSK with bit pattern or PRBS-9, symbols from timer1 compare B, phase registers
+// 20261016:    burst and gated output with the AD9833 SLEEP bits, gate input D2
+// 20261016:    sweep or hop table started by a rising edge at D2, early and missed triggers counted
+// 20261016:    'Q' one line status, '#Q' periodic telemetry into the serial buffer
 // 20221130:    allow .5M or 77k5 numeric format
 // 20221126:    correct the dB display for f > 1MHz (valid for full gain output)
 // 20221124:    provide dBV, dBu, dBm display, change with btn down when at -60dB
@@ -29,14 +54,16 @@ const char versionText[] PROGMEM = "Signal Generator 3 - " __DATE__ " " __TIME__
 
 const char helpText[] PROGMEM = "USB serial interface:\n"
                                 " [:num:]?[:cmd:]\n"
-                                " num = [-]?[0-9]{1,7}[kM]? e.g. '123' or '-10' or '150k' or '1M'\n"
+                                " num = [-]?[0-9]{1,8}[kM]? e.g. '123' or '-10' or '150k' or '1M', max. 12.5M\n"
                                 " also possible: .5M or 77k5\n"
+                                " frequencies with mHz resolution: 1000.25 or 1.2345678k\n"
+                                " binary frames: 0xA5 len ops xor, answer ACK or NAK\n"
                                 " cmd:\n"
                                 " ?: show status\n"
                                 " A: digital pot linear setting, num = 0..255, <0 = 0ff\n"
                                 " B: digital pot log setting, num = 1..16, 0: off\n"
-                                " C: -\n"
-                                " D: set dB gain, num = -50..+10, smaller values = off\n"
+                                " C: custom sweep ms[,steps[,mode]], mode: +1 lin, +2 down, +4 triangle\n"
+                                " D: set dB gain, num = -50.0..+10.0, 0.1 dB steps, smaller values = off\n"
                                 " E: echo on/off\n"
                                 " F: constant freq1\n"
                                 " G: sweep 1s from freq1 to freq2\n"
@@ -44,12 +71,12 @@ const char helpText[] PROGMEM = "USB serial interface:\n"
                                 " I: sweep 10s from freq1 to freq2\n"
                                 " J: sweep 30s from freq1 to freq2\n"
                                 " K: n/a (kilo)\n"
-                                " L: -\n"
+                                " L: show and clear task timing histogram\n"
                                 " M: n/a (Mega)\n"
-                                " N: -\n"
+                                " N: hop table, freq,ms[,dB]N: add entry, N: clear\n"
                                 " O: output off\n"
-                                " P: -\n"
-                                " Q: -\n"
+                                " P: play hop table, 1: once, 2: loop, other: stop\n"
+                                " Q: query, one line: Q,freq1,freq2,fw,wave,sweep,step,steps,pot,dB,unit\n"
                                 " R: output rectangle\n"
                                 " S: output sine\n"
                                 " T: output triangle\n"
@@ -57,18 +84,35 @@ const char helpText[] PROGMEM = "USB serial interface:\n"
                                 " V: select dBV\n"
                                 " W: select dBm\n"
                                 " X: exchange freq1 and freq2\n"
-                                " Y: -\n"
-                                " Z: set debug level";
+                                " Y: show and clear task statistics\n"
+                                " Z: set debug level\n"
+                                " #C: show level calibration, n,dB#C: set point n\n"
+                                " #D: default level calibration\n"
+                                " #S: save level calibration\n"
+                                " n#R: recall preset n, 0: last state\n"
+                                " n#W: store preset n = 1..8\n"
+                                " n#F: FSK freq1 / freq2 with n symbols/s, 0: stop\n"
+                                " n[,deg]#P: PSK freq1 with n symbols/s, phase of bit 1 ( 180 ), 0: stop\n"
+                                " value,bits#T: keying pattern, bits = 1..16, MSB first, #T: PRBS-9\n"
+                                " on,off#G: burst, cycles of freq1, 1#G: gate with input D2, 0#G: stop\n"
+                                " n#A: trigger with rising edge at D2, 1: one sweep, 2: hop table once, 0: off\n"
+                                " n#Q: telemetry, query line every n ms ( 10..60000 ), 0: off";
 //
 //-----------------------------------------------------------------------------
 
-#include <SPI.h>
-#include <Wire.h>
-#include <math.h>
+#include <EEPROM.h>
 
 #include "AD9833.h"
+#include "Button.h"
+#include "HAL.h"
+#include "HopTable.h"
+#include "LevelTables.h"
 #include "MCP4x.h"
+#include "Modulator.h"
 #include "SimpleSH1106.h"
+#include "Scheduler.h"
+#include "SpiBus.h"
+#include "Sweep.h"
 
 
 //-----------------------------------------------------------------------------
@@ -85,7 +129,11 @@ const char helpText[] PROGMEM = "USB serial interface:\n"
 // Global Constants
 //-----------------------------------------------------------------------------
 
-const long BAUDRATE = 9600; // Baud rate of UART in bps
+const long BAUDRATE = 115200; // Baud rate of UART in bps
+
+const uint16_t TICKRATE = 1000; // scheduler ticks per second = sweep steps per second
+
+const uint8_t BUTTONTICKS = 5; // button scan period, debounce and repeat times are multiples of it
 
 // connection to MCP41010
 const int MCP_CS = 9;
@@ -104,6 +152,14 @@ MCP4x MCP( MCP_CS );
 
 AD9833 AD( AD_FSYNC );
 
+Sweep SW;
+
+HopTable HOP;
+
+Modulator MOD;
+
+Scheduler SCH( halMicros ); // task timing from the timer1 counter
+
 
 //-----------------------------------------------------------------------------
 // globals used in SigGen
@@ -111,7 +167,7 @@ AD9833 AD( AD_FSYNC );
 
 const char *dBstrings[] = { "dBm", "dBu", "dBV" };
 
-const float dBfullScale[ 3 ] = { 7.0f, 3.0f, 1.1f }; // dBm (@50Ω), dBu (unloaded), dBV (unloaded)
+const int8_t dBfullScale[ 3 ] = { 70, 30, 11 }; // 0.1 dB: dBm (@50Ω), dBu (unloaded), dBV (unloaded)
 
 static const uint8_t gainToPot[ 3 ][ 16 ] = {
     {
@@ -132,14 +188,48 @@ static const uint8_t gainToPot[ 3 ][ 16 ] = {
 };
 
 // the digital pot has gain degradation above 1 MHz - see data sheet DS11195C-page 9
-// dB correction values for f > 1 MHz and full scale gain
-const int8_t dBcorrMHz[] = { 0, 0, 0, -1, -2, -3, -4, -5, -6, -7 }; // 0.x, 1.x, 2.x ... 9.x MHz
-
-const uint8_t numDigits = 7; // number of digits ( nOD ) in the number arrays
-// three number arrays: data input, start and stop frequency
-uint8_t dataInput[ numDigits ] = { 0, 0, 0, 0, 0, 0, 0 }; // data input accumulator
-uint8_t freqStart[ numDigits ] = { 0, 0, 0, 0, 0, 0, 0 }; // 0Hz, cursor pos = 0..numDigits-1
-uint8_t freqStop[ numDigits ] = { 0, 0, 0, 0, 0, 0, 0 };  // 0Hz, cursor pos = numDigits..2*numDigits-1
+// calibration: output level in 0.1 dB relative to low frequencies at FREQ word i << CALSHIFT
+// ( every 781.25 kHz up to 10.16 MHz ), interpolated, compensated with the pot if possible
+// set with '#C', saved in EEPROM with '#S'
+const uint8_t CALSHIFT = 23;
+const uint8_t CALPOINTS = 14;
+const int8_t calDefault[ CALPOINTS ] PROGMEM = { 0, 0, 0, 0, -6, -14, -22, -30, -38, -45, -53, -61, -69, -77 }; // -1 dB/MHz above 2.5 MHz
+int8_t calTable[ CALPOINTS ];
+const int calAddr = E2END + 1 - CALPOINTS - 2; // at the end of the EEPROM: magic, table, checksum
+const uint8_t calMagic = 0xCA;
+
+// pot values for the current level in bins of 1 << LEVELSHIFT FREQ steps ( 195 kHz ) up to 10 MHz
+// calculated by updateLevel() when the level changes, looked up for each output change
+const uint8_t LEVELSHIFT = 21;
+const uint8_t LEVELBINS = ( ( 10000000ULL << 28 ) / AD9833::MCLK >> LEVELSHIFT ) + 1;
+uint8_t levelPot[ LEVELBINS ];
+uint32_t outputFw = 0; // FREQ word of the output, selects the level bin
+
+const uint8_t numDigits = 7;  // number of displayed frequency digits, the 1st one is the MHz value 0..12
+const uint8_t fracDigits = 3; // mHz digits of the serial input, not editable with the buttons
+const uint32_t maxHz = AD9833::MCLK / 2;
+const uint32_t powersOf10[] PROGMEM = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// a number of the serial input: integer value and thousandths, e.g. Hz and mHz
+struct number_t {
+    uint32_t value;
+    uint16_t milli;
+};
+// comma separated arguments before the last number, e.g. "1k,20,-10N"
+const uint8_t maxArgs = 2;
+number_t args[ maxArgs ];
+uint8_t argCount = 0;
+number_t dataInput = { 0, 0 }; // last number, freq1 if no number was entered
+
+// start and stop frequency, binary with the AD9833 FREQ word calculated once in setFreq()
+// the digits are derived only for the display
+struct freq_t {
+    uint32_t hz;
+    uint16_t milliHz;
+    uint32_t fw;
+};
+freq_t freqStart = { 0, 0, 0 }; // 0 Hz, cursor pos = 0..numDigits-1
+freq_t freqStop = { 0, 0, 0 };  // 0 Hz, cursor pos = numDigits..2*numDigits-1
 const uint8_t waveformPos = 2 * numDigits;                // cursor position for these items
 const uint8_t sweepPos = 2 * numDigits + 1;
 const uint8_t gainPos = 2 * numDigits + 2;
@@ -147,27 +237,113 @@ const uint8_t exchgPos = 2 * numDigits + 3;
 
 uint8_t cursor = 0; // point to MSB position of freqStart
 
-enum sweep_t { swOff = 0, sw1Sec, sw3Sec, sw10Sec, sw30Sec };
+enum sweep_t { swOff = 0, sw1Sec, sw3Sec, sw10Sec, sw30Sec, swCustom };
 sweep_t sweep = swOff;
 
+// sweep profile: duration of one sweep, number of steps, spacing and direction
+const uint8_t spLinear = 1;   // linear, else logarithmic
+const uint8_t spDown = 2;     // from freq2 to freq1
+const uint8_t spTriangle = 4; // up and down, duration is for one direction
+// sawtooth: steps + 1 values in duration, triangle: 2 * steps values in 2 * duration
+const uint32_t maxSweepMs = 3600000;
+struct sweepProfile_t {
+    uint32_t ms;
+    uint16_t steps; // 0: one step per tick
+    uint8_t mode;
+};
+sweepProfile_t customSweep = { 5000, 0, 0 }; // set with command 'C'
+
+// armed sweep: sweepValues values in sweepPeriod ticks, see stepSweep()
+uint32_t sweepValues = 1;
+uint32_t sweepPeriod = 1;
+uint32_t sweepPhase = 0;
+bool sweepSync = false; // the preloaded value starts a sweep
+uint32_t sweepNext = 0; // preloaded FREQ word
+uint32_t sweepStep = 0; // index of the output value in the sweep period, 0..sweepValues-1
+
 uint16_t waveType = AD9833::wSine;
+const uint16_t waveTypes[] = { AD9833::wReset, AD9833::wSine, AD9833::wTriangle, AD9833::wRectangle }; // frame and query
 uint8_t gain = 0;
-int8_t dB = 0;
+uint8_t potValue = 0; // pot setting for gain at low frequencies
+int16_t dB = 0; // level in 0.1 dB
 
 enum dB_t { dBm = 0, dBu, dBV };
 dB_t dBtype = dBm; //
 
 uint8_t debug = 0;
 
+uint16_t telemetryMs = 0; // '#Q' period, 0: off
+uint32_t telemetryLines = 0; // query lines sent
+uint16_t telemetryDrops = 0; // lines skipped, the serial buffer stayed full
+// a query line is written when the serial buffer has room for most of them, the longest
+// ( 71 bytes ) waits for at most 15 bytes, 1.3 ms at 115200 baud
+const uint8_t telemetryRoom = 56;
+
+// FSK / PSK / burst / gate, see startModulation()
+enum modulation_t { mdFsk = 0, mdPsk, mdBurst, mdGate };
+modulation_t modType = mdFsk;
+const uint16_t maxBaud = 10000; // symbols per second
+uint16_t modBaud = 0;
+uint16_t modPhase = 1800; // PSK: phase of bit 1 in 0.1°
+uint16_t burstOn = 10;    // burst: cycles of freq1 on and off
+uint16_t burstOff = 90;
+
+// external trigger, see triggerEdge()
+enum trigger_t { trOff = 0, trSweep, trHop };
+trigger_t trigMode = trOff;
+const uint8_t tsIdle = 0;    // not ready, e.g. after the end of a sweep, see armTrigger()
+const uint8_t tsArmed = 1;   // output off, waiting for the edge
+const uint8_t tsRunning = 2; // sweep or hop table started by the edge
+volatile uint8_t trigState = tsIdle;
+uint16_t trigControl = 0; // CONTROL word that starts the armed sweep
+bool trigLevel = false;   // level of extIn at the last pin change
+volatile uint16_t trigCount = 0;
+volatile uint16_t trigEarly = 0;  // edges during a running sweep or hop table
+volatile uint16_t trigMissed = 0; // edges while not armed or pulses shorter than the latency
+
+//-----------------------------------------------------------------------------
+// Presets
+//   preset 0 is the last state, saved presetDelay ms after the last change and
+//   restored at power-on, presets 1..presetCount-1 are stored and recalled by command
+//   records ( slot, sequence, preset, checksum ) are written in a ring below the calibration,
+//   a new record never overwrites the newest record of a preset ( wear levelling )
+//   the presets are ready to write: FREQ words and pot value are stored, not recalculated
+//-----------------------------------------------------------------------------
+struct preset_t {
+    freq_t freqStart;
+    freq_t freqStop;
+    sweepProfile_t customSweep;
+    uint16_t waveType;
+    int16_t dB;
+    uint8_t gain;
+    uint8_t potValue;
+    uint8_t dBtype;
+    uint8_t sweep;
+};
+const uint8_t presetCount = 9;
+const uint16_t presetDelay = 5000; // ms without change before the last state is saved
+const uint8_t recordSize = 1 + 4 + sizeof( preset_t ) + 2;
+const uint8_t recordCount = calAddr / recordSize;
+uint8_t presetRecord[ recordSize ]; // record to write, see presetTask()
+int presetAddr = 0;
+uint8_t presetStep = recordSize + 1; // next byte of presetRecord to write, > recordSize: idle
+uint16_t presetSaved = 0;            // checksum of the last state in the EEPROM
+
 // button inputs
 const int btnLeft = 8;  // pushbutton
 const int btnRight = 7; // pushbutton
 const int btnDown = 6;  // pushbutton
 const int btnUp = 5;    // pushbutton
-const int testOut = 4;  // output for a test signal
-const int pwmOut = 3;   // output rectangle to create a neg. voltage
+const int testOut = 4;  // output for a test signal, sync pulse at the start of a sweep
+const int extIn = 2;    // external input, gate or trigger, see halStartPinChange()
+const int pwmOut = 3;   // output rectangle to create a neg. voltage, see halInitChargePump()
+
+// debounced with auto-repeat, scanned by buttonTask()
+Button keyLeft( btnLeft );
+Button keyRight( btnRight );
+Button keyDown( btnDown );
+Button keyUp( btnUp );
 
-uint16_t sweepPosition, sweepSteps;
 
 
 //-----------------------------------------------------------------------------
@@ -176,18 +352,27 @@ uint16_t sweepPosition, sweepSteps;
 //-----------------------------------------------------------------------------
 void setup( void ) {
     // Open serial port with a baud rate of BAUDRATE b/s
-    Serial.begin( BAUDRATE );
+    halSerialBegin( BAUDRATE );
 
     // Activate interrupts
     sei();
 
-    Serial.println( (__FlashStringHelper *)versionText );
+    halSerial.println( (__FlashStringHelper *)versionText );
+
+    halInitChargePump( pwmOut ); // init timer2 output for neg. voltage charge pump
+    initButtons();       // prepare the UI buttons
+    initSigGen();        // output the last state as fast as possible
+    OLED.init();         // then init the display
+    showMenu();
 
-    initTimer1( 250 ); // init timer1 for sweep timing
-    initTimer2();      // init timer2 output for neg. voltage charge pump
-    initButtons();     // prepare the UI buttons
-    OLED.init();       // init the display
-    initSigGen();      // and finally init the signal generator
+    // tasks in order of priority: name, period [ticks], deadline [us]
+    SCH.add( sweepTask, PSTR( "sweep" ), 1, 200 );
+    SCH.add( buttonTask, PSTR( "buttons" ), BUTTONTICKS, 500 );
+    SCH.add( serialTask, PSTR( "serial" ), 1, 1000 );
+    SCH.add( displayTask, PSTR( "display" ), 1, 5000 );
+    SCH.add( presetTask, PSTR( "preset" ), 1, 2000 );
+    SCH.add( telemetryTask, PSTR( "telemetry" ), 1, 2000 );
+    halInitTick( TICKRATE, timerTick ); // init timer1 for the scheduler tick
 }
 
 
@@ -195,7 +380,7 @@ void setup( void ) {
 // Main routines
 // loop
 //-----------------------------------------------------------------------------
-void loop( void ) { execMenu(); }
+void loop( void ) { SCH.run(); }
 
 
 //-----------------------------------------------------------------------------
@@ -271,105 +456,282 @@ const uint8_t imgUpDown[] PROGMEM = {
     0x10, 0x18, 0xFC, 0xFE, 0xFC, 0x18, 0x10, 0x10, 0x30, 0x7F, 0xFF, 0x7F, 0x30, 0x10,
 };
 
+//-----------------------------------------------------------------------------
+// screen areas ( widgets ) that are redrawn by showMenu() when invalid
+//-----------------------------------------------------------------------------
+const uint8_t wgFrame = 0x01;  // box, title and labels
+const uint8_t wgFreq1 = 0x02;  // digits of freq1 from invalidDigit[ 0 ] on
+const uint8_t wgFreq2 = 0x04;  // digits of freq2 from invalidDigit[ 1 ] on
+const uint8_t wgCursor = 0x08; // cursor moved
+const uint8_t wgGain = 0x10;   // gain bar
+const uint8_t wgLevel = 0x20;  // dB value and unit
+const uint8_t wgWave = 0x40;   // waveform
+const uint8_t wgSweep = 0x80;  // sweep mode
+const uint8_t wgAll = 0xFF;
+
+uint8_t invalid = wgAll;
+uint8_t invalidDigit[ 2 ] = { 0, 0 }; // first digit to redraw of freq1 and freq2
+uint8_t digitCol[ 2 * numDigits ];    // column of each drawn digit
+
+
+// mark widgets for redraw, wgFreq1 / wgFreq2 redraw all digits
+void invalidate( uint8_t widgets ) {
+    invalid |= widgets;
+    if ( widgets & wgFreq1 )
+        invalidDigit[ 0 ] = 0;
+    if ( widgets & wgFreq2 )
+        invalidDigit[ 1 ] = 0;
+}
+
+
+// mark a changed digit of freq1 or freq2, the digits right of it move if its width changes
+void invalidateDigit( uint8_t pos ) {
+    const uint8_t row = pos < numDigits ? 0 : 1;
+    pos -= row * numDigits;
+    if ( pos < invalidDigit[ row ] )
+        invalidDigit[ row ] = pos;
+    invalid |= row ? wgFreq2 : wgFreq1;
+    if ( pos < 3 && row == 0 )
+        invalid |= wgLevel; // the level correction depends on the frequency
+}
+
+
 //-----------------------------------------------------------------------------
 // showMenu
-// draw a box and show complete generator status
+//   draw the box and the generator status, only the invalid widgets are redrawn
+//   a change between constant and sweep layout redraws all
+//   without the frame buffer one widget or part of one per call, about what fits
+//   into the I2C queue, and only when the previous one has been sent
 //-----------------------------------------------------------------------------
 void showMenu( void ) {
-    uint8_t col, page, i;
-    OLED.drawBox( F( "Signal Generator 3" ) );
-
-    // show a vertical logarithmic gain bar on the left
-    drawGain();
+    static bool sweepLayout = false;
+    static uint8_t drawnCursor = 0;
+    static uint8_t framePart = 0; // next part of the box
+    uint8_t col, page;
+    uint32_t i2cBytes = OLED.byteCount;
+#if !SH1106_FRAMEBUFFER
+    if ( TwiQ.busy() )
+        return;
+#endif
+    if ( ( sweep != swOff ) != sweepLayout ) {
+        sweepLayout = sweep != swOff;
+        invalidate( wgAll );
+        framePart = 0;
+    }
+    if ( drawnCursor != cursor ) {
+        if ( drawnCursor == waveformPos || cursor == waveformPos )
+            invalid |= wgWave; // the cursor overlaps the waveform
+        if ( !( invalid & wgFrame ) )
+            drawCursor( drawnCursor, false );
+        drawnCursor = cursor;
+        invalid |= wgCursor;
+    }
+#if SH1106_FRAMEBUFFER
+    uint8_t todo = invalid; // flush() sends only the changes
+#else
+    uint8_t todo = invalid & -invalid; // lowest widget first, the box before the rest
+#endif
 
-    if ( sweep == swOff ) { // one large frequency display
-        page = 2;
-        col = 20;
-        for ( i = 0; i < numDigits; ++i ) {
-            if ( i == cursor )
-                OLED.drawImage( col + 2, page + 2, imgCurUp );
-            col += OLED.drawInt( freqStart[ i ], col, page, OLED.largeDigitsFont );
-        }
-        OLED.drawImage( col + 2, page, imgHz ); // display "Hz" as image (large font is num-only)
-    } else {                                    // two small frequencies (sweep start and stop frequency)
-        // 1st row
-        page = 2;
-        col = 70;
-        OLED.drawString( F( "Start Freq: " ), 24, page, OLED.smallFont );
-        for ( i = 0; i < numDigits; ++i ) {
-            if ( i == cursor )
-                OLED.drawImage( col - 2, page + 1, imgCurUp );
-            col += OLED.drawInt( freqStart[ i ], col, page, OLED.smallFont );
-        }
-        OLED.drawString( F( " Hz" ), col, page, OLED.smallFont );
-        // 2nd row
-        page = 4;
-        col = 70;
-        OLED.drawString( F( "Stop Freq: " ), 24, page, OLED.smallFont );
-        for ( i = 0; i < numDigits; ++i ) {
-            if ( i == cursor - numDigits )
-                OLED.drawImage( col - 2, page + 1, imgCurUp );
-            col += OLED.drawInt( freqStop[ i ], col, page, OLED.smallFont );
-        }
-        OLED.drawString( F( " Hz" ), col, page, OLED.smallFont );
+    if ( todo & wgFrame ) {
+        do {
+            OLED.drawBox( F( "Signal Generator 3" ), framePart );
+            if ( sweepLayout && framePart == 2 * 2 ) // left half of page 2
+                OLED.drawString( F( "Start Freq: " ), 24, 2, OLED.smallFont );
+            if ( sweepLayout && framePart == 2 * 4 )
+                OLED.drawString( F( "Stop Freq: " ), 24, 4, OLED.smallFont );
+        } while ( ++framePart < SimpleSH1106::BOX_PARTS && SH1106_FRAMEBUFFER );
+        if ( framePart < SimpleSH1106::BOX_PARTS )
+            todo &= ~wgFrame; // continue with the next part
+        else
+            framePart = 0;
     }
 
+    // show a vertical logarithmic gain bar on the left
+    if ( todo & wgGain )
+        drawGain();
+
+    // one large frequency display or two small frequencies ( sweep start and stop frequency )
+    if ( todo & wgFreq1 )
+        invalidDigit[ 0 ] = drawFreq( 0, invalidDigit[ 0 ] );
+    if ( sweepLayout && ( todo & wgFreq2 ) )
+        invalidDigit[ 1 ] = drawFreq( 1, invalidDigit[ 1 ] );
+    else if ( todo & wgFreq2 )
+        invalidDigit[ 1 ] = numDigits; // not shown
+    for ( uint8_t row = 0; row < 2; ++row )
+        if ( invalidDigit[ row ] < numDigits )
+            todo &= ~( row ? wgFreq2 : wgFreq1 ); // continue with the next digits
+    if ( todo & ( wgFrame | wgFreq1 | wgFreq2 | wgCursor ) )
+        drawCursor( cursor, true ); // also if the box or the freq redraw touched it
+
     // show dB amplitude below gain bar
     page = 6;
-    col = 2;
-    int8_t dBcorr = dBcorrMHz[ *freqStart ];
-    col += OLED.drawInt( dB + dBcorr, col, page, OLED.smallFont );
-
-    OLED.drawString( dBstrings[ dBtype ], col, page, OLED.smallFont );
-    if ( cursor == waveformPos )
-        OLED.drawImage( 33, page + 1, imgCurRt );
+    if ( todo & wgLevel ) { // drawn over the former level, the rest cleared after
+        col = 2;
+        const int16_t level = outputLevel( freqStart.fw );
+        col += OLED.drawInt( ( level + ( level < 0 ? -5 : 5 ) ) / 10, col, page, OLED.smallFont );
+        col += OLED.drawString( dBstrings[ dBtype ], col, page, OLED.smallFont );
+        if ( col < 36 )
+            OLED.fillArea( col, page, 36 - col, 0 );
+    }
 
-    // show two periods of wave form
+    // show two periods of wave form, the images include the bottom line of the box
     const uint8_t startcol = 36;
-    for ( col = startcol; col < ( startcol + 2 * 14 ); col += 14 )
-        switch ( waveType ) {
-        case AD9833::wReset:
-            if ( startcol == col )
-                OLED.drawString( F( "OFF" ), col, page, OLED.smallFont );
+    if ( todo & wgWave ) {
+        if ( waveType == AD9833::wReset ) {
+            col = startcol + OLED.drawString( F( "OFF" ), startcol, page, OLED.smallFont );
+            OLED.fillArea( col, page, startcol + 2 * 14 - col, 0 );
+            if ( cursor == waveformPos ) // keep the cursor tip
+                OLED.fillArea( startcol + 1, page + 1, 2 * 14 - 1, 0x80 );
+            else
+                OLED.fillArea( startcol, page + 1, 2 * 14, 0x80 ); // bottom line of the box
+        } else {
+            const uint8_t *img = waveType == AD9833::wSine ? imgSine : waveType == AD9833::wTriangle ? imgTria : imgRect;
+            for ( col = startcol; col < ( startcol + 2 * 14 ); col += 14 )
+                OLED.drawImage( col, page, img );
+            if ( cursor == waveformPos )
+                drawCursor( cursor, true ); // the tip is in the image
+        }
+    }
+
+    // display sweep time, drawn over the former text, the rest cleared after
+    col = 70;
+    if ( todo & wgSweep ) {
+        switch ( sweep ) {
+        case swOff:
+            if ( !MOD.running() ) {
+                col += OLED.drawString( F( "Constant" ), col, page, OLED.smallFont );
+            } else if ( modType == mdBurst ) {
+                col += OLED.drawString( F( "Burst " ), col, page, OLED.smallFont );
+                col += OLED.drawInt( burstOn, col, page, OLED.smallFont );
+                col += OLED.drawString( F( "/" ), col, page, OLED.smallFont );
+                col += OLED.drawInt( burstOff, col, page, OLED.smallFont );
+            } else if ( modType == mdGate ) {
+                col += OLED.drawString( F( "Gate" ), col, page, OLED.smallFont );
+            } else {
+                col += OLED.drawString( modType == mdPsk ? F( "PSK " ) : F( "FSK " ), col, page, OLED.smallFont );
+                col += OLED.drawInt( modBaud, col, page, OLED.smallFont );
+            }
             break;
-        case AD9833::wSine:
-            OLED.drawImage( col, page, imgSine );
+        case sw1Sec:
+            col += OLED.drawString( F( "Sweep 1 s" ), col, page, OLED.smallFont );
             break;
-        case AD9833::wTriangle:
-            OLED.drawImage( col, page, imgTria );
+        case sw3Sec:
+            col += OLED.drawString( F( "Sweep 3 s" ), col, page, OLED.smallFont );
             break;
-        case AD9833::wRectangle:
-            OLED.drawImage( col, page, imgRect );
+        case sw10Sec:
+            col += OLED.drawString( F( "Sweep 10 s" ), col, page, OLED.smallFont );
+            break;
+        case sw30Sec:
+            col += OLED.drawString( F( "Sweep 30 s" ), col, page, OLED.smallFont );
+            break;
+        case swCustom:
+            col += OLED.drawString( F( "Custom" ), col, page, OLED.smallFont );
             break;
         }
+        if ( col < 127 )
+            OLED.fillArea( col, page, 127 - col, 0 );
+    }
+    invalid &= ~todo;
 
-    // display sweep time
-    page = 6;
-    col = 70;
-    switch ( sweep ) {
-    case swOff:
-        OLED.drawString( F( "Constant" ), col, page, OLED.smallFont );
-        break;
-    case sw1Sec:
-        OLED.drawString( F( "Sweep 1 s" ), col, page, OLED.smallFont );
-        break;
-    case sw3Sec:
-        OLED.drawString( F( "Sweep 3 s" ), col, page, OLED.smallFont );
-        break;
-    case sw10Sec:
-        OLED.drawString( F( "Sweep 10 s" ), col, page, OLED.smallFont );
-        break;
-    case sw30Sec:
-        OLED.drawString( F( "Sweep 30 s" ), col, page, OLED.smallFont );
-        break;
+    OLED.flush(); // queue the changes for the display
+    if ( debug ) {
+        halSerial.print( F( "showMenu() I2C bytes: " ) );
+        halSerial.print( OLED.byteCount - i2cBytes );
+        halSerial.print( F( ", queue max: " ) );
+        halSerial.print( TwiQ.highWater );
+        halSerial.print( F( ", dropped: " ) );
+        halSerial.println( TwiQ.drops );
     }
+}
 
-    if ( cursor == sweepPos )
-        OLED.drawImage( col - 6, 6, imgCurRt );
-    else if ( cursor == exchgPos )
-        OLED.drawImage( 12, 2, imgUpDown );
-    else if ( cursor == gainPos )
-        OLED.drawImage( 4, 5, imgCurUp );
+
+// draw the digits of freq1 ( row 0 ) or freq2 ( row 1 ) from digit first on and the unit
+// the digits are drawn over the old ones, the rest of the former row is cleared after
+// without the frame buffer the large digits take several calls, returns the next digit to draw
+const uint8_t freqDigitsPerCall = SH1106_FRAMEBUFFER ? numDigits : 3; // large digits, about 120 I2C bytes
+uint8_t drawFreq( uint8_t row, uint8_t first ) {
+    static uint8_t digitsEnd[ 2 ] = { 0, 0 }; // unit column of the drawn row
+    static uint8_t endCol[ 2 ] = { 127, 127 }; // end of the drawn row
+    const bool small = sweep != swOff;
+    const SimpleSH1106::Font &font = small ? OLED.smallFont : OLED.largeDigitsFont;
+    const uint8_t page = 2 + 2 * row;
+    uint8_t digits[ numDigits ];
+    freqDigits( row ? freqStop.hz : freqStart.hz, digits );
+    uint8_t *cols = digitCol + row * numDigits;
+    if ( !first )
+        cols[ 0 ] = small ? 70 : 20;
+    if ( cursor >= row * numDigits + first && cursor < ( row + 1 ) * numDigits )
+        drawCursor( cursor, false ); // the columns right of first may move
+    uint8_t col = cols[ first ];
+    uint8_t last = small ? numDigits : first + freqDigitsPerCall;
+    if ( last > numDigits )
+        last = numDigits;
+    for ( uint8_t i = first; i < last; ++i ) {
+        cols[ i ] = col;
+        col += OLED.drawInt( digits[ i ], col, page, font );
+    }
+    if ( last < numDigits ) {
+        cols[ last ] = col;
+        return last;
+    }
+    if ( first && col == digitsEnd[ row ] )
+        return numDigits; // the unit did not move
+    digitsEnd[ row ] = col;
+    if ( small )
+        col += OLED.drawString( F( " Hz" ), col, page, OLED.smallFont );
+    else if ( col + 2 + pgm_read_byte( imgHz ) < 127 ) { // no room for the unit above 10 MHz
+        OLED.fillArea( col, page, 2, 0 );
+        OLED.fillArea( col, page + 1, 2, 0 );
+        col += 2 + OLED.drawImage( col + 2, page, imgHz ); // display "Hz" as image (large font is num-only)
+    }
+    if ( col < endCol[ row ] )
+        for ( uint8_t p = page; p < page + font.height; ++p )
+            OLED.fillArea( col, p, endCol[ row ] - col, 0 );
+    endCol[ row ] = col;
+    return numDigits;
+}
+
+
+// draw or erase the cursor mark for cursor position pos
+void drawCursor( uint8_t pos, bool show ) {
+    const uint8_t *img;
+    uint8_t col, page;
+    if ( pos < 2 * numDigits ) { // below a digit
+        img = imgCurUp;
+        if ( sweep == swOff ) {
+            if ( pos >= numDigits ) // freq2 is not shown
+                return;
+            col = digitCol[ pos ] + 2;
+            page = 4;
+        } else {
+            col = digitCol[ pos ] - 2;
+            page = pos < numDigits ? 3 : 5;
+        }
+    } else if ( pos == waveformPos ) {
+        img = imgCurRt;
+        col = 33;
+        page = 7;
+    } else if ( pos == sweepPos ) {
+        img = imgCurRt;
+        col = 64;
+        page = 6;
+    } else if ( pos == gainPos ) {
+        img = imgCurUp;
+        col = 4;
+        page = 5;
+    } else { // exchgPos
+        img = imgUpDown;
+        col = 12;
+        page = 2;
+    }
+    if ( show ) {
+        OLED.drawImage( col, page, img );
+    } else {
+        const uint8_t width = pgm_read_byte( img );
+        const uint8_t pages = pgm_read_byte( img + 1 );
+        for ( uint8_t p = page; p < page + pages; ++p )
+            OLED.fillArea( col, p, width, p == 7 ? 0x80 : 0 ); // keep the bottom line of the box
+    }
 }
 
 
@@ -377,345 +739,953 @@ void showMenu( void ) {
 void drawGain() {
     uint32_t bar4 = 0xFFFFFFFFL << ( 32 - 2 * gain );
     for ( uint8_t page = 1; page < 5; ++page ) {
-        for ( uint8_t col = 4; col < 10; ++col )
-            OLED.drawBar( col, page, lowByte( bar4 ) );
+        OLED.fillArea( 4, page, 6, lowByte( bar4 ) );
         bar4 >>= 8;
     }
 }
 
 
 //-----------------------------------------------------------------------------
-// execMenu
-//   show menu
-//   check for serial command
-//   check for pressed select or adjust buttons
-//   advance sweep frequency if sweep active
+// Tasks
+//   called by the scheduler SCH, see setup()
+//   newFrequency is set by the UI tasks and handled by sweepTask()
+//   invalid widgets are redrawn by displayTask()
 //-----------------------------------------------------------------------------
-void execMenu( void ) {
-    static uint8_t prevLeft = 0;
-    static uint8_t prevRight = 0;
-    static uint8_t prevUp = 0;
-    static uint8_t prevDown = 0;
+bool newFrequency = false;
+bool modRequest = false;   // set by '#F', '#P' and '#G', handled by sweepTask()
 
-    uint8_t btn;
 
-    showMenu();
+//-----------------------------------------------------------------------------
+// sweepTask
+//   every tick: set a new frequency or advance the sweep one step
+//-----------------------------------------------------------------------------
+void sweepTask( void ) {
+    static sweep_t armedSweep = swOff;
+    static bool test = true;
+    if ( sweep == swOff ) { // test signal with half tick rate, sync pulse when sweeping
+        test = !test;
+        halDigitalWrite( testOut, test );
+    }
 
-    sweepPosition = 0;
+    if ( HOP.playing() ) { // the timer1 interrupt owns the output
+        if ( !newFrequency && sweep == armedSweep )
+            return;
+        HOP.stop();
+    }
 
-    do {
-        bool newFrequency = parseSerial();
-
-        btn = digitalRead( btnUp );
-        if ( btn != prevUp ) { // button status has changed
-            prevUp = btn;
-            if ( btn == LOW ) { // pressed
-                incItem();
-                showMenu();
-                newFrequency = true;
-            }
-            myDelay( 100 );
-            // StartTimer1( 0 );
-        }
+    if ( modRequest ) { // modulation replaces sweep and constant output
+        modRequest = false;
+        HOP.stop();
+        stopModulation();
+        disarmTrigger();
+        sweep = armedSweep = swOff;
+        startModulation();
+        newFrequency = false;
+        return;
+    }
+    if ( MOD.running() ) { // the symbol or gate interrupt owns the output
+        if ( !newFrequency && sweep == armedSweep )
+            return;
+        stopModulation();
+    }
 
-        btn = digitalRead( btnDown );
-        if ( btn != prevDown ) {
-            prevDown = btn;
-            if ( btn == LOW ) {
-                decItem();
-                showMenu();
-                newFrequency = true;
-            }
-            myDelay( 100 );
-            // StartTimer1( 0 );
+    if ( trigMode == trSweep && sweep == swOff ) // constant output ends the triggered sweep
+        disarmTrigger();
+    if ( trigMode != trOff ) { // sweep or hop table started by extIn, see triggerEdge()
+        if ( newFrequency || sweep != armedSweep || trigState == tsIdle ) {
+            armedSweep = sweep;
+            armTrigger();
+        } else if ( trigState == tsRunning ) {
+            if ( trigMode == trSweep )
+                stepSweep(); // armTrigger() at the end of the sweep
+            else if ( !HOP.playing() )
+                armTrigger();
         }
+        newFrequency = false;
+        return;
+    }
 
-        btn = digitalRead( btnLeft );
-        if ( btn != prevLeft ) {
-            prevLeft = btn;
-            if ( btn == LOW ) {
-                cursorLeft();
-                showMenu();
-            }
-            myDelay( 100 );
-            // StartTimer1( 0 );
+    if ( sweep == swOff ) {
+        armedSweep = swOff;
+        if ( newFrequency ) {
+            outputFw = freqStart.fw;
+            SpiBus::begin();
+            AD.setFreqWord( outputFw, waveType );
+            refreshPot();
+            SpiBus::end();
         }
-
-        btn = digitalRead( btnRight );
-        if ( btn != prevRight ) {
-            prevRight = btn;
-            if ( btn == LOW ) {
-                cursorRight();
-                showMenu();
-            }
-            myDelay( 100 );
-            // StartTimer1( 0 );
+    } else {
+        if ( newFrequency || sweep != armedSweep ) { // (re)start with new parameters
+            armSweep( false );
+            armedSweep = sweep;
+        } else {
+            stepSweep(); // advance the frequency one step
         }
+    }
+    newFrequency = false;
+}
 
-        static bool test = true;
-        while ( !( TIFR1 & _BV( OCF1A ) ) ) // wait for timer1 output compare match every ms
-            ;
-        test = !test; // toggle the test pin
-        digitalWrite( testOut, test );
 
-        if ( sweep == swOff ) {
-            if ( newFrequency ) {
-                AD.setFrequency( calcNumber( freqStart ), waveType );
-                setGain();
-            }
-        } else {
-            switch ( sweep ) {
-            case sw1Sec:
-                sweepSteps = 1000L;
-                break;
-            case sw3Sec:
-                sweepSteps = 3000L;
-                break;
-            case sw10Sec:
-                sweepSteps = 10000L;
-                break;
-            case sw30Sec:
-                sweepSteps = 30000L;
-                break;
-            default:
-                break;
+//-----------------------------------------------------------------------------
+// buttonTask
+//   every BUTTONTICKS: check for pressed or held select or adjust buttons
+//   the changed widgets are redrawn by displayTask()
+//-----------------------------------------------------------------------------
+void buttonTask( void ) {
+    if ( keyUp.update() ) {
+        incItem();
+        newFrequency = true;
+    }
+    if ( keyDown.update() ) {
+        decItem();
+        newFrequency = true;
+    }
+    if ( keyLeft.update() )
+        cursorLeft();
+    if ( keyRight.update() )
+        cursorRight();
+}
+
+
+//-----------------------------------------------------------------------------
+// serialTask
+//   check for serial command
+//-----------------------------------------------------------------------------
+void serialTask( void ) {
+    if ( parseSerial() )
+        newFrequency = true;
+}
+
+
+//-----------------------------------------------------------------------------
+// displayTask
+//   redraw the invalid widgets, at most once per tick
+//   continue sending display changes, never waits
+//-----------------------------------------------------------------------------
+void displayTask( void ) {
+    if ( invalid )
+        showMenu();
+    OLED.flush();
+}
+
+
+//-----------------------------------------------------------------------------
+// presetTask
+//   write the pending preset record one byte per tick when the EEPROM is ready,
+//   else check the settings every 100 ms and save them as last state
+//   when they are unchanged for presetDelay ms
+//-----------------------------------------------------------------------------
+void presetTask( void ) {
+    static uint8_t countdown = 0;
+    static uint16_t lastCheck = 0;
+    static uint32_t changed = 0;
+    if ( presetStep <= recordSize ) {
+        if ( eeprom_is_ready() )
+            writePresetByte();
+        return;
+    }
+    if ( countdown-- )
+        return;
+    countdown = 100 / ( 1000 / TICKRATE ) - 1;
+    preset_t p;
+    getPreset( p );
+    const uint16_t check = fletcher16( (const uint8_t *)&p, sizeof( p ) );
+    const uint32_t ms = millis();
+    if ( check != lastCheck ) {
+        lastCheck = check;
+        changed = ms;
+    } else if ( check != presetSaved && ms - changed >= presetDelay ) {
+        storePreset( 0 );
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// telemetryTask
+//   every telemetryMs: write the query line straight into the serial buffer
+//   as soon as it has telemetryRoom, a line still waiting at the next period is dropped
+//-----------------------------------------------------------------------------
+void telemetryTask( void ) {
+    static uint16_t elapsed = 0;
+    static bool pending = false;
+    if ( !telemetryMs ) {
+        elapsed = 0;
+        pending = false;
+        return;
+    }
+    if ( ++elapsed >= uint32_t( telemetryMs ) * TICKRATE / 1000 ) {
+        elapsed = 0;
+        if ( pending )
+            ++telemetryDrops;
+        pending = true;
+    }
+    if ( pending && halSerial.availableForWrite() >= telemetryRoom ) {
+        printQuery( halSerial );
+        pending = false;
+        ++telemetryLines;
+    }
+}
+
+
+// print and clear the scheduler statistics
+void showTasks() {
+    for ( uint8_t i = 0; i < SCH.count(); ++i ) {
+        const Scheduler::Task &t = SCH.task( i );
+        halSerial.print( (__FlashStringHelper *)t.name );
+        halSerial.print( F( ": period " ) );
+        halSerial.print( t.period );
+        halSerial.print( F( " ticks, deadline " ) );
+        halSerial.print( t.deadline );
+        halSerial.print( F( " us, worst " ) );
+        halSerial.print( t.worst );
+        halSerial.print( F( " us, overruns " ) );
+        halSerial.print( t.overruns );
+        halSerial.print( F( ", runs " ) );
+        halSerial.println( t.runs );
+    }
+    SCH.clearStats();
+}
+
+
+// print and clear the task run times and the missed ticks
+void showTiming() {
+#if SCHEDULER_STATS
+    static const uint16_t binLimit[ Scheduler::BINS - 1 ] PROGMEM = { 16, 64, 256, 1024, 4096 };
+    for ( uint8_t i = 0; i < SCH.count(); ++i ) {
+        const Scheduler::Task &t = SCH.task( i );
+        halSerial.print( (__FlashStringHelper *)t.name );
+        if ( !t.runs ) {
+            halSerial.println( F( ": no runs" ) );
+            continue;
+        }
+        halSerial.print( F( ": min " ) );
+        halSerial.print( t.best );
+        halSerial.print( F( " us, mean " ) );
+        halSerial.print( t.total / t.runs );
+        halSerial.print( F( " us, max " ) );
+        halSerial.print( t.worst );
+        halSerial.print( F( " us," ) );
+        for ( uint8_t bin = 0; bin < Scheduler::BINS; ++bin ) {
+            if ( bin < Scheduler::BINS - 1 ) {
+                halSerial.print( F( " <" ) );
+                halSerial.print( pgm_read_word( binLimit + bin ) );
+            } else {
+                halSerial.print( F( " more" ) );
             }
-            stepSweep( true ); // advance the frequency one step (true: up, false: down)
+            halSerial.print( ':' );
+            halSerial.print( t.histogram[ bin ] );
         }
-        TIFR1 = 0xFF; // clear all timer1 flags
-    } while ( true );
+        halSerial.println();
+    }
+#else
+    halSerial.println( F( "run time histogram: build with SCHEDULER_STATS 1" ) );
+#endif
+    halSerial.print( F( "missed ticks: " ) );
+    halSerial.println( SCH.missed );
+    SCH.clearStats();
 }
 
 
 //-----------------------------------------------------------------------------
 // parseSerial
-//   if a uint8_t is available in the serial input buffer
-//   collect numbers or execute it as a command
+//   handle all bytes that are in the serial input buffer
+//   binary frames are handled by parseFrame(), all other bytes by parseChar()
+//   the menu is redrawn once by displayTask() after the batch
+//-----------------------------------------------------------------------------
+bool parseSerial( void ) {
+    bool newFrequency = false;
+    for ( int n = halSerial.available(); n > 0; --n ) { // bytes that arrive meanwhile wait for the next tick
+        uint8_t c = halSerial.read();
+        if ( !parseFrame( c ) && parseChar( c ) )
+            newFrequency = true;
+    }
+    return newFrequency;
+}
+
+
+//-----------------------------------------------------------------------------
+// parseChar
+//   collect numbers or execute a command
 //   number up to 7 digits, format can be:
 //     123 or 10k or 1.5M or 77k5 or .05M
+//   up to 3 digits right of the decimal point ( after shifting ) are kept as mHz
 //-----------------------------------------------------------------------------
-bool parseSerial( void ) {
+bool parseChar( char c ) {
     static bool echo = false;
-    static bool numeric = false; // input of argument
-    static int8_t digits = 0;    // number of entered digits
-    static int8_t decimal = 0;   // number of decimal digits
-    static int8_t kiloMega = 0;  // number of shifts if 'k' or 'M' was input
+    static bool numeric = false;    // input of argument
+    static int8_t digits = 0;       // number of entered digits
+    static bool fractional = false; // digits go into the fraction
+    static uint32_t whole = 0;      // integer part of the input
+    static uint32_t fraction = 0;   // fraction part of the input with fracCount digits
+    static uint8_t fracCount = 0;
+    static int8_t kiloMega = 0; // number of shifts if 'k' or 'M' was input
     static bool minus = false;
+    static bool extended = false; // '#' received, next char is an extended command
     bool newFrequency = false;
-    if ( Serial.available() > 0 ) {
-        char c = Serial.read();
-        if ( echo )
-            Serial.write( c );
-        if ( c == '-' ) {
-            numeric = true;
-            minus = true;
-        } else if ( c == '.' ) {
-            numeric = true;
-            decimal = digits + 1; // position _before_ nth digit to catch input like ".123" -> digits = 3, decimal = 1
-        } else if ( ( c >= '0' ) && ( c <= '9' ) ) {
-            for ( int i = 0; i < numDigits - 1; ++i )
-                dataInput[ i ] = numeric ? dataInput[ i + 1 ] : 0; // clear all or shift left
-            dataInput[ numDigits - 1 ] = c - '0';                  // add new digit at the right
-            if ( !numeric ) {
-                kiloMega = 0;
-                digits = 0;
-                decimal = 0;
-            }
-            numeric = true; // we are in argument input mode
-            digits++;
-        } else if ( c == 'k' || c == 'K' ) {
-            if ( !kiloMega ) {  // apply only once
-                kiloMega = 3;   // shift << 3
-                if ( !decimal ) // e.g. 1k7
-                    decimal = digits + 1;
-                else
-                    numeric = false;
-            }
-        } else if ( c == 'M' || c == 'm' ) {
-            if ( !kiloMega ) {  // apply only once
-                kiloMega = 6;   // shift << 6
-                if ( !decimal ) // e.g. 1M5 = 1.5M
-                    decimal = digits + 1;
-                else
-                    numeric = false;
-            }
-        } else {
-            // all other non numeric char stop number input
-            numeric = false;                           // no more digits
-            if ( digits && ( decimal || kiloMega ) ) { // handle 1.5M or 77k5
-                int8_t shift = kiloMega;
-                if ( decimal )
-                    shift -= digits - decimal + 1;
-                if ( shift < 0 ) {
-                    shift = -shift;
-                    for ( int i = numDigits - 1; i >= 0; --i ) {                  // 6..0
-                        dataInput[ i ] = i >= shift ? dataInput[ i - shift ] : 0; // 0 -> value >>
-                    }
-                } else if ( shift > 0 ) {
-                    for ( int i = 0; i < numDigits; ++i ) {                                      // 0..6
-                        dataInput[ i ] = i > numDigits - 1 - shift ? 0 : dataInput[ i + shift ]; //  << value <- 0
-                    }
+    if ( echo )
+        halSerial.write( c );
+    if ( !numeric && ( c == '-' || c == '.' || ( ( c >= '0' ) && ( c <= '9' ) ) ) ) {
+        dataInput = { 0, 0 }; // start a new number
+        digits = 0;
+        fractional = false;
+        whole = 0;
+        fraction = 0;
+        fracCount = 0;
+        kiloMega = 0;
+    }
+    if ( c == '-' ) {
+        numeric = true;
+        minus = true;
+    } else if ( c == '.' ) {
+        numeric = true;
+        fractional = true; // also input like ".123"
+    } else if ( ( c >= '0' ) && ( c <= '9' ) ) {
+        // collect integer and fraction part binary, scaled to Hz when input is complete
+        if ( !fractional ) {
+            whole = whole > 99999999 ? 999999999 : whole * 10 + c - '0'; // saturate, checked by the commands
+        } else if ( fracCount < 9 ) { // ignore digits below 1 nHz
+            fraction = fraction * 10 + c - '0';
+            ++fracCount;
+        }
+        numeric = true; // we are in argument input mode
+        digits++;
+    } else if ( c == 'k' || c == 'K' ) {
+        if ( !kiloMega ) {     // apply only once
+            kiloMega = 3;      // shift << 3
+            if ( !fractional ) // e.g. 1k7
+                fractional = true;
+            else
+                numeric = false;
+        }
+    } else if ( c == 'M' || c == 'm' ) {
+        if ( !kiloMega ) {     // apply only once
+            kiloMega = 6;      // shift << 6
+            if ( !fractional ) // e.g. 1M5 = 1.5M
+                fractional = true;
+            else
+                numeric = false;
+        }
+    } else {
+        // all other non numeric char stop number input
+        numeric = false; // no more digits
+        if ( digits )    // scale to Hz, handle 1.5M or 77k5
+            dataInput = scaleNumber( whole, fraction, fracCount, kiloMega );
+        digits = 0;
+        fractional = false;
+        kiloMega = 0;
+        if ( extended ) { // '#x'
+            extended = false;
+            c = toupper( c );
+            newFrequency = parseExtended( c, minus );
+            // telemetry, cal table output and EEPROM writes leave the menu unchanged
+            if ( c != 'Q' && c != 'S' && c != 'W' && !( c == 'C' && argCount == 0 ) )
+                invalidate( wgAll );
+            minus = false;
+            argCount = 0;
+            return newFrequency;
+        }
+        bool redraw = true; // false: the command leaves the menu unchanged
+        switch ( toupper( c ) ) {
+        case '?':
+            halSerial.println( (__FlashStringHelper *)versionText );
+            halSerial.println( (__FlashStringHelper *)helpText );
+            showStatus();
+            break;
+        case 'A': { // digital pot setting 0..255, < 0 switches off
+            int16_t a = dataInput.value > 255 ? 255 : dataInput.value;
+            if ( minus )
+                a = -a;
+            minus = false;
+            setLinGain( a );
+            popFreq();
+            invalidate( wgAll );
+            break;
+        }
+        case 'B': { // set internal gain step 0..16 , kind of logarithmic shape
+            gain = minus ? 0 : dataInput.value > 16 ? 16 : dataInput.value;
+            minus = false;
+            setGain();
+            popFreq();
+            invalidate( wgAll );
+            break;
+        }
+        case 'C': { // custom sweep: ms[,steps[,mode]]C
+            uint32_t last = dataInput.value;
+            customSweep.steps = 0;
+            customSweep.mode = 0;
+            if ( argCount == 0 ) {
+                customSweep.ms = last;
+            } else {
+                customSweep.ms = args[ 0 ].value;
+                if ( argCount == 1 ) {
+                    customSweep.steps = last > 0xFFFF ? 0xFFFF : last;
+                } else {
+                    uint32_t steps = args[ 1 ].value;
+                    customSweep.steps = steps > 0xFFFF ? 0xFFFF : steps;
+                    customSweep.mode = last & ( spLinear | spDown | spTriangle );
                 }
-                digits = 0;
-                decimal = 0;
-                kiloMega = 0;
             }
-            switch ( toupper( c ) ) {
-            case '?':
-                Serial.println( (__FlashStringHelper *)versionText );
-                Serial.println( (__FlashStringHelper *)helpText );
-                showStatus();
+            if ( customSweep.ms > maxSweepMs )
+                customSweep.ms = maxSweepMs;
+            sweep = swCustom;
+            popFreq();
+            newFrequency = true; // rearm also if already custom
+            break;
+        }
+        case 'D': // set dB gain, value = -50.0..+10.0 dBm, smaller values = off
+            setdBGain( calcTenths( dataInput, minus ) );
+            minus = false;
+            popFreq();
+            invalidate( wgAll );
+            break;
+        case 'E': // toggle terminal echo
+            echo = !echo;
+            redraw = false;
+            break;
+        case 'F': // freq1 (no sweep)
+            sweep = swOff;
+            newFrequency = true;
+            break;
+        case 'G': // sweep from freq1 to freq2 within 1 second
+            sweep = sw1Sec;
+            break;
+        case 'H': // sweep 3s
+            sweep = sw3Sec;
+            break;
+        case 'I': // sweep 10s
+            sweep = sw10Sec;
+            break;
+        case 'J': // sweep 30s
+            sweep = sw30Sec;
+            break;
+        case 'L': // show and clear task timing
+            showTiming();
+            break;
+        case 'N': { // hop table: freq,ms[,dB]N adds an entry, without arguments: clear
+            if ( argCount == 1 )
+                addHop( args[ 0 ], dataInput.value, false, 0 );
+            else if ( argCount == 2 )
+                addHop( args[ 0 ], args[ 1 ].value, true, calcTenths( dataInput, minus ) );
+            else
+                HOP.clear();
+            popFreq();
+            break;
+        }
+        case 'O': // output off
+            HOP.stop();
+            stopModulation();
+            disarmTrigger();
+            AD.reset();
+            waveType = AD9833::wReset;
+            break;
+        case 'P': // play hop table, 1: once, 2: loop, other: stop
+            switch ( dataInput.value ) {
+            case 1:
+                HOP.play( false );
                 break;
-            case 'A': { // digital pot setting 0..255, < 0 switches off
-                int16_t a = int16_t( minus ? -calcNumber( dataInput ) : calcNumber( dataInput ) );
-                minus = false;
-                if ( a > 255 )
-                    a = 255;
-                setLinGain( a );
-                popFreq();
-                showMenu();
+            case 2:
+                HOP.play( true );
                 break;
-            }
-            case 'B': { // set internal gain step 0..16 , kind of logarithmic shape
-                int8_t b = int8_t( minus ? -calcNumber( dataInput ) : calcNumber( dataInput ) );
-                minus = false;
-                if ( b < 0 )
-                    b = 0;
-                else if ( b > 16 )
-                    b = 16;
-                gain = b;
-                setGain();
-                popFreq();
-                showMenu();
+            default:
+                HOP.stop();
                 break;
             }
-            case 'C':
-                break;
-            case 'D': // set dB gain, value = -50..+10 dBm, smaller values = off
-                setdBGain( minus ? -calcNumber( dataInput ) : calcNumber( dataInput ) );
-                minus = false;
-                popFreq();
-                showMenu();
-                break;
-            case 'E': // toggle terminal echo
-                echo = !echo;
-                break;
-            case 'F': // freq1 (no sweep)
-                sweep = swOff;
-                newFrequency = true;
-                break;
-            case 'G': // sweep from freq1 to freq2 within 1 second
-                sweep = sw1Sec;
-                break;
-            case 'H': // sweep 3s
-                sweep = sw3Sec;
-                break;
-            case 'I': // sweep 10s
-                sweep = sw10Sec;
-                break;
-            case 'J': // sweep 30s
-                sweep = sw30Sec;
-                break;
-            case 'L':
-                break;
-            case 'N':
-                break;
-            case 'O': // output off
-                AD.reset();
-                waveType = AD9833::wReset;
-                break;
-            case 'P':
-                break;
-            case 'Q':
-                break;
-            case 'R': // rectangle output
-                waveType = AD9833::wRectangle;
-                newFrequency = true;
-                break;
-            case 'S': // sine output
-                waveType = AD9833::wSine;
-                newFrequency = true;
-                break;
-            case 'T': // triangle output
-                waveType = AD9833::wTriangle;
-                newFrequency = true;
-                break;
-            case 'U': // set dbu display
-                dBtype = dBu;
-                setGain();
-                break;
-            case 'V': // set dBV display
-                dBtype = dBV;
-                setGain();
-                break;
-            case 'W': // set dBm display
-                dBtype = dBm;
-                setGain();
-                break;
-            case 'X': // exchange freq1 and freq2
-                exchgFreq();
-                popFreq();
-                newFrequency = true;
-                break;
-            case 'Y':
+            popFreq();
+            break;
+        case 'Q': // query
+            printQuery( halSerial );
+            redraw = false;
+            break;
+        case 'R': // rectangle output
+            waveType = AD9833::wRectangle;
+            newFrequency = true;
+            break;
+        case 'S': // sine output
+            waveType = AD9833::wSine;
+            newFrequency = true;
+            break;
+        case 'T': // triangle output
+            waveType = AD9833::wTriangle;
+            newFrequency = true;
+            break;
+        case 'U': // set dbu display
+            dBtype = dBu;
+            setGain();
+            break;
+        case 'V': // set dBV display
+            dBtype = dBV;
+            setGain();
+            break;
+        case 'W': // set dBm display
+            dBtype = dBm;
+            setGain();
+            break;
+        case 'X': // exchange freq1 and freq2
+            exchgFreq();
+            popFreq();
+            newFrequency = true;
+            break;
+        case 'Y': // show and clear task statistics
+            showTasks();
+            break;
+        case 'Z':
+            debug = dataInput.value;
+            minus = false;
+            popFreq();
+            break;
+        case '#': // prefix of an extended command, number and arguments are kept
+            extended = true;
+            return false;
+        case ',': // argument separator, the number is kept for the next command
+            if ( argCount < maxArgs )
+                args[ argCount++ ] = dataInput;
+            dataInput = { 0, 0 }; // empty argument = 0
+            minus = false;
+            return false;
+        default:
+            argCount = 0;
+            return false;
+        }
+        if ( newFrequency ) {
+            enterFreq();
+        }
+        if ( redraw )
+            invalidate( wgAll );
+        minus = false;
+        argCount = 0;
+    }
+    return newFrequency;
+}
+
+
+//-----------------------------------------------------------------------------
+// parseExtended
+//   execute the extended command '#c'
+//   C: show level calibration, n,dB#C: set point n
+//   D: default level calibration
+//   S: save level calibration
+//   R: recall preset n, W: store preset n
+//-----------------------------------------------------------------------------
+bool parseExtended( char c, bool minus ) {
+    switch ( c ) {
+    case 'C':
+        if ( argCount == 1 ) {
+            const uint32_t i = args[ 0 ].value;
+            int16_t corr = calcTenths( dataInput, minus );
+            if ( i >= CALPOINTS || corr < -128 || corr > 127 ) {
+                halSerial.println( F( "cal point or level out of range" ) );
                 break;
-            case 'Z':
-                debug = calcNumber( dataInput );
-                minus = false;
-                popFreq();
+            }
+            calTable[ i ] = corr;
+            updateLevel();
+            refreshPot();
+        } else {
+            showCal();
+        }
+        break;
+    case 'D':
+        defaultCal();
+        updateLevel();
+        refreshPot();
+        break;
+    case 'S':
+        saveCal();
+        break;
+    case 'R':
+        if ( dataInput.value < presetCount && recallPreset( dataInput.value ) )
+            return true;
+        halSerial.println( F( "preset not stored" ) );
+        break;
+    case 'W':
+        if ( dataInput.value > 0 && dataInput.value < presetCount )
+            storePreset( dataInput.value );
+        else
+            halSerial.println( F( "preset out of range" ) );
+        break;
+    case 'F': // FSK: n#F
+    case 'P': { // PSK: n[,deg]#P
+        const uint32_t baud = argCount ? args[ 0 ].value : dataInput.value;
+        if ( !baud ) { // back to constant output
+            stopModulation();
+            popFreq();
+            return true;
+        }
+        if ( baud > maxBaud ) {
+            halSerial.println( F( "symbol rate out of range" ) );
+            break;
+        }
+        modBaud = baud;
+        modType = c == 'P' ? mdPsk : mdFsk;
+        if ( modType == mdPsk ) {
+            int16_t phase = argCount ? calcTenths( dataInput, minus ) % 3600 : 1800;
+            modPhase = phase < 0 ? phase + 3600 : phase;
+        }
+        modRequest = true; // starts after the serial input, see sweepTask()
+        break;
+    }
+    case 'T': // keying pattern: value,bits#T, #T: PRBS-9
+        if ( !argCount )
+            MOD.setPattern( 0, Modulator::PRBS );
+        else if ( args[ 0 ].value <= 0xFFFF && dataInput.value >= 1 && dataInput.value <= Modulator::BITS )
+            MOD.setPattern( args[ 0 ].value, dataInput.value );
+        else
+            halSerial.println( F( "pattern out of range" ) );
+        break;
+    case 'G': // burst: on,off#G in cycles of freq1, 1#G: gate with extIn, 0#G: stop
+        if ( ( argCount || dataInput.value == 1 ) && waveType == AD9833::wRectangle ) {
+            // with OPBITEN the comparator output stays at the last MSB while the DAC sleeps
+            halSerial.println( F( "burst and gate need sine or triangle" ) );
+            break;
+        }
+        if ( argCount ) {
+            if ( !args[ 0 ].value || args[ 0 ].value + dataInput.value > 0xFFFF || !freqStart.hz ) {
+                halSerial.println( F( "burst out of range" ) );
                 break;
-            default:
+            }
+            burstOn = args[ 0 ].value;
+            burstOff = dataInput.value;
+            modType = mdBurst;
+        } else if ( dataInput.value == 1 ) {
+            modType = mdGate;
+        } else { // back to constant output
+            stopModulation();
+            popFreq();
+            return true;
+        }
+        modRequest = true;
+        break;
+    case 'Q': // telemetry: n#Q every n ms, 0#Q: off
+        if ( dataInput.value && ( dataInput.value < 10 || dataInput.value > 60000 ) )
+            halSerial.println( F( "telemetry period out of range" ) );
+        else
+            telemetryMs = dataInput.value;
+        break;
+    case 'A': // trigger: 1#A sweep, 2#A hop table, 0#A: off
+        if ( dataInput.value == trSweep && sweep == swOff ) {
+            halSerial.println( F( "select a sweep first" ) );
+        } else if ( dataInput.value == trHop && !HOP.count() ) {
+            halSerial.println( F( "hop table empty" ) );
+        } else if ( dataInput.value == trSweep || dataInput.value == trHop ) {
+            stopModulation();
+            disarmTrigger();
+            trigMode = trigger_t( dataInput.value );
+            trigCount = trigEarly = trigMissed = 0;
+            trigLevel = halExtInput();
+            halStartPinChange( triggerEdge ); // armed by sweepTask()
+        } else {
+            disarmTrigger();
+            popFreq();
+            return true; // free running again
+        }
+        break;
+    default:
+        break;
+    }
+    popFreq();
+    return false;
+}
+
+
+//-----------------------------------------------------------------------------
+// parseFrame
+//   collect a binary frame, return false if c does not belong to a frame
+//   frame: FRAMESYNC, length, length bytes of operations, XOR of length and operations
+//   the complete frame is checked before execution and answered by ACK or NAK
+//   operations ( little endian ):
+//     0x01 Hz[4] mHz[2]: freq1
+//     0x02 Hz[4] mHz[2]: freq2
+//     0x03 dB[1]: level ( signed )
+//     0x04 wave[1]: 0: off, 1: sine, 2: triangle, 3: rectangle
+//     0x05 sweep[1]: 0: constant, 1..4: sweep 1s, 3s, 10s, 30s, 5: custom
+//     0x06 ms[4] steps[2] mode[1]: custom sweep profile, see command 'C'
+//-----------------------------------------------------------------------------
+const uint8_t FRAMESYNC = 0xA5; // not used by the text commands
+const uint8_t FRAMEMAX = 32;    // max. length of the operations
+const uint8_t ACK = 0x06;
+const uint8_t NAK = 0x15;
+
+bool parseFrame( uint8_t c ) {
+    enum { frIdle, frLength, frData, frCheck };
+    static uint8_t state = frIdle;
+    static uint8_t frame[ FRAMEMAX ];
+    static uint8_t length;
+    static uint8_t received;
+    static uint8_t check;
+    switch ( state ) {
+    case frIdle:
+        if ( c != FRAMESYNC )
+            return false;
+        state = frLength;
+        break;
+    case frLength:
+        length = c;
+        received = 0;
+        check = c;
+        state = length > FRAMEMAX ? frIdle : length ? frData : frCheck;
+        if ( state == frIdle )
+            halSerial.write( NAK );
+        break;
+    case frData:
+        frame[ received++ ] = c;
+        check ^= c;
+        if ( received == length )
+            state = frCheck;
+        break;
+    case frCheck:
+        state = frIdle;
+        if ( c == check && execFrame( frame, length, false ) ) {
+            execFrame( frame, length, true );
+            halSerial.write( ACK );
+        } else {
+            halSerial.write( NAK );
+        }
+        break;
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// execFrame
+//   check ( execute = false ) or execute the operations of a binary frame
+//   one deferred display refresh for all operations
+//-----------------------------------------------------------------------------
+bool execFrame( const uint8_t *op, uint8_t length, bool execute ) {
+    const uint8_t *end = op + length;
+    while ( op < end ) {
+        uint8_t code = *op++;
+        uint8_t size = ( code == 0x01 || code == 0x02 ) ? 6 : code == 0x06 ? 7 : 1;
+        if ( code < 0x01 || code > 0x06 || end - op < size )
+            return false;
+        switch ( code ) {
+        case 0x01: // freq1
+        case 0x02: { // freq2
+            uint32_t hz = 0;
+            for ( uint8_t i = 4; i--; )
+                hz = ( hz << 8 ) | op[ i ];
+            uint16_t milliHz = op[ 4 ] | ( op[ 5 ] << 8 );
+            if ( hz > maxHz || milliHz > 999 )
+                return false;
+            if ( execute )
+                setFreq( code == 0x01 ? freqStart : freqStop, hz, milliHz );
+            break;
+        }
+        case 0x03: // level dB
+            if ( execute )
+                setdBGain( int8_t( *op ) * 10 );
+            break;
+        case 0x04: // wave
+            if ( *op > 3 )
                 return false;
+            if ( execute ) {
+                waveType = waveTypes[ *op ];
+                if ( waveType == AD9833::wReset ) {
+                    HOP.stop();
+                    stopModulation();
+                    disarmTrigger();
+                    AD.reset();
+                }
             }
-            if ( newFrequency ) {
-                enterFreq();
+            break;
+        case 0x05: // sweep
+            if ( *op > swCustom )
+                return false;
+            if ( execute )
+                sweep = sweep_t( *op );
+            break;
+        case 0x06: { // custom sweep profile
+            uint32_t ms = 0;
+            for ( uint8_t i = 4; i--; )
+                ms = ( ms << 8 ) | op[ i ];
+            if ( ms > maxSweepMs || op[ 6 ] & ~( spLinear | spDown | spTriangle ) )
+                return false;
+            if ( execute ) {
+                customSweep.ms = ms;
+                customSweep.steps = op[ 4 ] | ( op[ 5 ] << 8 );
+                customSweep.mode = op[ 6 ];
+                sweep = swCustom;
             }
-            showMenu();
-            minus = false;
+            break;
         }
+        }
+        op += size;
+    }
+    if ( execute ) {
+        popFreq();
+        newFrequency = true;
+        invalidate( wgAll );
+    }
+    return true;
+}
+
+
+// print a frequency in Hz, mHz only if not zero
+void printFreq( const freq_t &f ) {
+    printHz( halSerial, f );
+    halSerial.print( F( " Hz" ) );
+}
+
+
+// the number only, e.g. 1000.25
+void printHz( Print &out, const freq_t &f ) {
+    out.print( f.hz );
+    if ( f.milliHz ) {
+        out.write( '.' );
+        if ( f.milliHz < 100 )
+            out.write( '0' );
+        if ( f.milliHz < 10 )
+            out.write( '0' );
+        out.print( f.milliHz );
     }
-    return newFrequency;
 }
 
 
 // show status
 void showStatus() {
-    Serial.println();
+    halSerial.println();
     switch ( waveType ) {
     case AD9833::wSine:
-        Serial.print( F( "Sine " ) );
+        halSerial.print( F( "Sine " ) );
         break;
     case AD9833::wTriangle:
-        Serial.print( F( "Triangle " ) );
+        halSerial.print( F( "Triangle " ) );
         break;
     case AD9833::wRectangle:
-        Serial.print( F( "Rectangle " ) );
+        halSerial.print( F( "Rectangle " ) );
         break;
     case AD9833::wReset:
-        Serial.print( F( "Off " ) );
+        halSerial.print( F( "Off " ) );
         break;
     }
     if ( sweep != swOff ) {
-        Serial.print( F( "sweep " ) );
+        halSerial.print( F( "sweep " ) );
         if ( sweep == sw1Sec )
-            Serial.print( F( "1 s " ) );
+            halSerial.print( F( "1 s " ) );
         else if ( sweep == sw3Sec )
-            Serial.print( F( "3 s " ) );
+            halSerial.print( F( "3 s " ) );
         else if ( sweep == sw10Sec )
-            Serial.print( F( "10 s " ) );
+            halSerial.print( F( "10 s " ) );
         else if ( sweep == sw30Sec )
-            Serial.print( F( "30 s " ) );
+            halSerial.print( F( "30 s " ) );
+        else if ( sweep == swCustom ) {
+            halSerial.print( customSweep.ms );
+            halSerial.print( F( " ms " ) );
+            if ( customSweep.steps ) {
+                halSerial.print( customSweep.steps );
+                halSerial.print( F( " steps " ) );
+            }
+            halSerial.print( customSweep.mode & spLinear ? F( "lin " ) : F( "log " ) );
+            if ( customSweep.mode & spTriangle )
+                halSerial.print( F( "triangle " ) );
+            else if ( customSweep.mode & spDown )
+                halSerial.print( F( "down " ) );
+        }
     }
-    Serial.print( calcNumber( freqStart ) );
-    Serial.print( F( " Hz" ) );
+    printFreq( freqStart );
     if ( sweep != swOff ) {
-        Serial.print( F( " to " ) );
-        Serial.print( calcNumber( freqStop ) );
-        Serial.print( F( " Hz" ) );
+        halSerial.print( F( " to " ) );
+        printFreq( freqStop );
+    }
+    halSerial.write( ' ' );
+    printdB( dB );
+    halSerial.println();
+    if ( HOP.count() ) {
+        halSerial.print( F( "hop table: " ) );
+        halSerial.print( HOP.count() );
+        halSerial.println( HOP.playing() ? F( " entries, playing" ) : F( " entries" ) );
+    }
+    if ( telemetryMs ) {
+        halSerial.print( F( "telemetry every " ) );
+        halSerial.print( telemetryMs );
+        halSerial.print( F( " ms, " ) );
+        halSerial.print( telemetryLines );
+        halSerial.print( F( " lines, dropped: " ) );
+        halSerial.println( telemetryDrops );
+    }
+    if ( trigMode != trOff ) {
+        noInterrupts();
+        const uint16_t count = trigCount;
+        const uint16_t early = trigEarly;
+        const uint16_t missed = trigMissed;
+        interrupts();
+        halSerial.print( trigMode == trSweep ? F( "trigger sweep, " ) : F( "trigger hop table, " ) );
+        halSerial.print( trigState == tsRunning ? F( "running, " ) : F( "armed, " ) );
+        halSerial.print( count );
+        halSerial.print( F( " triggers, " ) );
+        halSerial.print( early );
+        halSerial.print( F( " early, " ) );
+        halSerial.print( missed );
+        halSerial.println( F( " missed" ) );
+    }
+    if ( MOD.running() && modType == mdBurst ) {
+        halSerial.print( F( "burst " ) );
+        halSerial.print( burstOn );
+        halSerial.print( F( " cycles on, " ) );
+        halSerial.print( burstOff );
+        halSerial.println( F( " off" ) );
+    } else if ( MOD.running() && modType == mdGate ) {
+        halSerial.println( halExtInput() ? F( "gate on" ) : F( "gate off" ) );
+    } else if ( MOD.running() ) {
+        halSerial.print( modType == mdPsk ? F( "PSK " ) : F( "FSK " ) );
+        halSerial.print( modBaud );
+        halSerial.print( F( " symbols/s" ) );
+        if ( modType == mdPsk ) {
+            halSerial.print( F( ", bit 1: " ) );
+            printTenths( halSerial, modPhase );
+            halSerial.print( F( " deg" ) );
+        }
+        halSerial.println();
+    }
+    if ( debug ) {
+        halSerial.print( F( "AD9833 SPI words: " ) );
+        halSerial.print( AD.wordCount );
+        halSerial.print( F( ", skipped: " ) );
+        halSerial.print( AD.skipCount );
+        halSerial.print( F( ", MCP41010 writes: " ) );
+        halSerial.print( MCP.writeCount );
+        halSerial.print( F( ", skipped: " ) );
+        halSerial.print( MCP.skipCount );
+        halSerial.print( F( ", SPI transactions: " ) );
+        halSerial.println( SpiBus::transactions );
     }
-    Serial.write( ' ' );
-    Serial.print( dB );
-    Serial.println( dBstrings[ dBtype ] );
+}
+
+
+//-----------------------------------------------------------------------------
+// printQuery
+//   one machine readable line, e.g. Q,1000,20000,10737,1,4,120,29999,54,0.0,dBm
+//     freq1, freq2: Hz, with mHz if not 0
+//     fw: FREQ register value of the output
+//     wave: 0: off, 1: sine, 2: triangle, 3: rectangle ( like the binary frames )
+//     sweep: 0: constant, 1..4: 1 s, 3 s, 10 s, 30 s, 5: custom
+//     step, steps: output value and number of values of the sweep period
+//     pot: MCP41010 value, -1: shut down
+//     dB, unit: level in the selected unit
+//-----------------------------------------------------------------------------
+void printQuery( Print &out ) {
+    uint8_t wave = 0;
+    while ( wave < 3 && waveTypes[ wave ] != waveType )
+        ++wave;
+    out.print( F( "Q," ) );
+    printHz( out, freqStart );
+    out.write( ',' );
+    printHz( out, freqStop );
+    out.write( ',' );
+    out.print( outputFw );
+    out.write( ',' );
+    out.print( waveTypes[ wave ] == waveType ? wave : 0 );
+    out.write( ',' );
+    out.print( sweep );
+    out.write( ',' );
+    out.print( sweep == swOff ? 0 : sweepStep );
+    out.write( ',' );
+    out.print( sweep == swOff ? 1 : sweepValues );
+    out.write( ',' );
+    out.print( MCP.value() );
+    out.write( ',' );
+    printTenths( out, dB );
+    out.write( ',' );
+    out.println( dBstrings[ dBtype ] );
 }
 
 
@@ -731,6 +1701,7 @@ void cursorRight( void ) {
     // skip over the stop frequency display if no sweep
     if ( ( cursor >= numDigits ) && ( cursor < 2 * numDigits ) && ( sweep == swOff ) )
         cursor = waveformPos;
+    invalidate( wgCursor );
 }
 
 
@@ -746,6 +1717,7 @@ void cursorLeft( void ) {
     // skip over the stop frequency display if no sweep
     if ( ( cursor >= numDigits ) && ( cursor < 2 * numDigits ) && ( sweep == swOff ) )
         cursor = numDigits - 1;
+    invalidate( wgCursor );
 }
 
 
@@ -759,14 +1731,18 @@ void incItem( void ) {
             ++gain;
             setGain();
         }
+        invalidate( wgGain | wgLevel );
     } else if ( cursor == exchgPos ) {
         exchgFreq();
+        invalidate( wgFreq1 | wgFreq2 | wgLevel );
     } else if ( cursor == sweepPos ) {
-        if ( sweep == sw30Sec )
+        if ( sweep == swCustom )
             sweep = swOff;
         else
             sweep = sweep_t( sweep + 1 );
+        invalidate( wgSweep );
     } else if ( cursor == waveformPos ) {
+        invalidate( wgWave );
         switch ( waveType ) {
         case AD9833::wReset:
             waveType = AD9833::wSine;
@@ -782,15 +1758,11 @@ void incItem( void ) {
             break;
         }
     } else if ( cursor < numDigits ) {
-        if ( freqStart[ cursor ] >= 9 )
-            freqStart[ cursor ] = 0;
-        else
-            freqStart[ cursor ]++;
+        invalidateDigit( cursor );
+        stepDigit( freqStart, cursor, true );
     } else if ( sweep != swOff ) {
-        if ( freqStop[ cursor - numDigits ] >= 9 )
-            freqStop[ cursor - numDigits ] = 0;
-        else
-            freqStop[ cursor - numDigits ]++;
+        invalidateDigit( cursor );
+        stepDigit( freqStop, cursor - numDigits, true );
     }
 }
 
@@ -817,14 +1789,18 @@ void decItem( void ) {
             }
         }
         setGain();
+        invalidate( wgGain | wgLevel );
     } else if ( cursor == exchgPos ) {
         exchgFreq();
-    } else if ( cursor == sweepPos ) { // Off, 1s, 3s, 10s, 30s
+        invalidate( wgFreq1 | wgFreq2 | wgLevel );
+    } else if ( cursor == sweepPos ) { // Off, 1s, 3s, 10s, 30s, custom
         if ( sweep == swOff )
-            sweep = sw30Sec;
+            sweep = swCustom;
         else
             sweep = sweep_t( sweep - 1 );
+        invalidate( wgSweep );
     } else if ( cursor == waveformPos ) {
+        invalidate( wgWave );
         switch ( waveType ) {
         case AD.wReset:
             waveType = AD9833::wRectangle;
@@ -840,33 +1816,119 @@ void decItem( void ) {
             break;
         }
     } else if ( cursor < numDigits ) {
-        if ( freqStart[ cursor ] <= 0 )
-            freqStart[ cursor ] = 9;
-        else
-            freqStart[ cursor ]--;
+        invalidateDigit( cursor );
+        stepDigit( freqStart, cursor, false );
     } else if ( sweep != swOff ) {
-        if ( freqStop[ cursor - numDigits ] <= 0 )
-            freqStop[ cursor - numDigits ] = 9;
-        else
-            freqStop[ cursor - numDigits ]--;
+        invalidateDigit( cursor );
+        stepDigit( freqStop, cursor - numDigits, false );
+    }
+}
+
+
+uint32_t decimalWeight( uint8_t n ) {
+    return pgm_read_dword( powersOf10 + n );
+}
+
+
+//-----------------------------------------------------------------------------
+// scaleNumber
+//   combine integer and fraction part of the input with the k / M shift
+//   into value and thousandths, e.g. 77k5: 77, 5 ( 1 digit ), 3 -> 77500.000
+//-----------------------------------------------------------------------------
+number_t scaleNumber( uint32_t whole, uint32_t fraction, uint8_t fracCount, uint8_t shift ) {
+    number_t n = { 0, 0 };
+    if ( fracCount > shift ) { // fraction digits remain right of the point
+        const uint8_t rest = fracCount - shift;
+        const uint32_t weight = decimalWeight( rest );
+        n.value = fraction / weight;
+        fraction %= weight;
+        n.milli = rest > fracDigits ? fraction / decimalWeight( rest - fracDigits ) : fraction * decimalWeight( fracDigits - rest );
+    } else {
+        n.value = fraction * decimalWeight( shift - fracCount );
     }
+    const uint32_t scale = decimalWeight( shift );
+    if ( whole > ( 0xFFFFFFFF - n.value ) / scale )
+        n.value = 0xFFFFFFFF; // saturate, checked by the commands
+    else
+        n.value += whole * scale;
+    return n;
 }
 
 
 //-----------------------------------------------------------------------------
-// calculate the numeric value from an char array.
+// setFreq
+//   the only way to change a frequency, calculates the FREQ word once
+//   frequencies above maxHz are limited
 //-----------------------------------------------------------------------------
-unsigned long calcNumber( const uint8_t *charArray ) {
-    unsigned long number = 0;
+void setFreq( freq_t &f, uint32_t hz, uint16_t milliHz ) {
+    if ( hz >= maxHz ) {
+        hz = maxHz;
+        milliHz = 0;
+    }
+    f.hz = hz;
+    f.milliHz = milliHz;
+    f.fw = AD9833::freqWord( hz, milliHz );
+}
+
+
+// change the digit at pos ( 0: MHz ) up or down like the buttons, 9 <-> 0
+void stepDigit( freq_t &f, uint8_t pos, bool up ) {
+    const uint32_t weight = decimalWeight( numDigits - 1 - pos );
+    uint32_t digit = f.hz / weight;
+    if ( pos )
+        digit %= 10;
+    uint32_t hz = f.hz;
+    if ( up )
+        hz = digit >= 9 ? hz - digit * weight : hz + weight;
+    else
+        hz = digit == 0 ? hz + 9 * weight : hz - weight;
+    setFreq( f, hz, f.milliHz );
+}
+
+
+// the displayed digits of hz, the 1st digit is the MHz value, no division
+void freqDigits( uint32_t hz, uint8_t *digits ) {
     for ( uint8_t pos = 0; pos < numDigits; ++pos ) {
-        number *= 10;
-        number += charArray[ pos ];
+        const uint32_t weight = decimalWeight( numDigits - 1 - pos );
+        uint8_t digit = 0;
+        for ( ; hz >= weight; hz -= weight )
+            ++digit;
+        digits[ pos ] = digit;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// calculate a level in 0.1 dB from a number, e.g. -12.5 from 12 + 500 / 1000
+//-----------------------------------------------------------------------------
+int16_t calcTenths( const number_t &n, bool minus ) {
+    const uint16_t number = n.value > 999 ? 999 : n.value;
+    int16_t tenths = number * 10 + n.milli / 100;
+    return minus ? -tenths : tenths;
+}
+
+
+// print a level in 0.1 dB with unit, e.g. -12.5dBm
+void printdB( int16_t tenths ) {
+    printTenths( halSerial, tenths );
+    halSerial.print( dBstrings[ dBtype ] );
+}
+
+
+// the number only, e.g. -12.5
+void printTenths( Print &out, int16_t tenths ) {
+    if ( tenths < 0 ) {
+        out.write( '-' );
+        tenths = -tenths;
     }
-    return number;
+    out.print( tenths / 10 );
+    out.write( '.' );
+    out.print( tenths % 10 );
 }
 
 
-int8_t dBfromValue( int value ) { return int8_t( round( 20.0 * log10( ( value + 1 ) / 256.0 ) + dBfullScale[ dBtype ] ) ); }
+// level in 0.1 dB for a pot value 0..255, see LevelTables.h
+int16_t dBfromValue( int value ) { return int16_t( pgm_read_word( potTodB10 + value ) ) + dBfullScale[ dBtype ]; }
 
 
 void setPot( uint8_t value ) {
@@ -881,20 +1943,21 @@ void setGain() {
         if ( gain > 16 )
             gain = 16;
         int value = gainToPot[ dBtype ][ gain - 1 ];
-        setPot( value );
+        potValue = value;
         dB = dBfromValue( value );
+        updateLevel();
+        refreshPot();
         if ( debug ) {
-            Serial.print( F( "setGain() gain: " ) );
-            Serial.print( gain );
-            Serial.print( F( ", " ) );
-            Serial.print( dB );
-            Serial.print( dBstrings[ dBtype ] );
-            Serial.print( F( ", value: " ) );
-            Serial.println( value );
+            halSerial.print( F( "setGain() gain: " ) );
+            halSerial.print( gain );
+            halSerial.print( F( ", " ) );
+            printdB( dB );
+            halSerial.print( F( ", value: " ) );
+            halSerial.println( value );
         }
     } else {
         MCP.shutdown();
-        dB = -60;
+        dB = -600;
     }
 }
 
@@ -903,195 +1966,721 @@ void setLinGain( int value ) { // 0..255, value < 0 switches off
     if ( value < 0 ) {
         MCP.shutdown();
         gain = 0;
-        dB = -60;
+        dB = -600;
     } else {
         if ( value > 255 )
             value = 255;
-        setPot( value );
+        potValue = value;
         for ( gain = sizeof( gainToPot[ 0 ] ); gain > 0; --gain )
             if ( gainToPot[ dBtype ][ gain - 1 ] < value )
                 break;
         ++gain;
         dB = dBfromValue( value );
+        updateLevel();
+        refreshPot();
     }
     if ( debug ) {
-        Serial.print( F( "setLinGain() gain: " ) );
-        Serial.print( gain );
-        Serial.print( F( ", " ) );
-        Serial.print( dB );
-        Serial.print( dBstrings[ dBtype ] );
-        Serial.print( F( ", value: " ) );
-        Serial.println( value );
+        halSerial.print( F( "setLinGain() gain: " ) );
+        halSerial.print( gain );
+        halSerial.print( F( ", " ) );
+        printdB( dB );
+        halSerial.print( F( ", value: " ) );
+        halSerial.println( value );
     }
 }
 
 
-void setdBGain( int value ) {
-    value = int( round( 256 * pow( 10.0, ( value - dBfullScale[ dBtype ] ) / 20.0 ) ) );
-    setLinGain( value - 1 );
+// write the gain setting for the output frequency, e.g. after a sweep step or waveform change
+// only a table look up, no float math
+void refreshPot() {
+    if ( gain )
+        setPot( levelPot[ levelBin( outputFw ) ] );
+    else
+        MCP.shutdown();
+}
+
+
+uint8_t levelBin( uint32_t fw ) {
+    fw >>= LEVELSHIFT;
+    return fw < LEVELBINS ? fw : LEVELBINS - 1;
 }
 
 
 //-----------------------------------------------------------------------------
-// stepSweep
-//    ramp the sweep frequency logarithmically
-//    according to number of steps between start and stop
+// calCorrection
+//    level correction in 0.1 dB at FREQ word fw, linear between the calibration points
 //-----------------------------------------------------------------------------
-void stepSweep( bool stepUp ) {
-    if ( sweepPosition > sweepSteps )
-        sweepPosition = 0;
-    long f = exp( ( log( calcNumber( freqStop ) ) - log( calcNumber( freqStart ) ) ) *
-                      ( stepUp ? sweepPosition : sweepSteps - sweepPosition ) / sweepSteps +
-                  log( calcNumber( freqStart ) ) ) +
-             0.5;
-    AD.setFrequency( f, waveType );
-    setGain();
-    ++sweepPosition;
+int16_t calCorrection( uint32_t fw ) {
+    uint8_t i = fw >> CALSHIFT;
+    if ( i >= CALPOINTS - 1 )
+        return calTable[ CALPOINTS - 1 ];
+    const int16_t frac = ( fw >> ( CALSHIFT - 8 ) ) & 0xFF; // 1/256 of the interval
+    return calTable[ i ] + ( ( calTable[ i + 1 ] - calTable[ i ] ) * frac ) / 256;
 }
 
 
 //-----------------------------------------------------------------------------
-// exchgFreq
-//    exchange start and stop frequency
+// updateLevel
+//    calculate the pot value per frequency bin for the current level,
+//    called when the level or the calibration changes,
+//    sweep steps and hops only look up levelPot[]
+//    bins without correction use potValue unchanged
 //-----------------------------------------------------------------------------
-void exchgFreq() {
-    uint8_t x;
-    for ( uint8_t i = 0; i < numDigits; i++ ) {
-        x = freqStart[ i ];
-        freqStart[ i ] = freqStop[ i ];
-        freqStop[ i ] = x;
+void updateLevel() {
+    for ( uint8_t bin = 0; bin < LEVELBINS; ++bin ) {
+        const int16_t corr = calCorrection( ( uint32_t( bin ) << LEVELSHIFT ) + ( 1UL << ( LEVELSHIFT - 1 ) ) );
+        const int value = corr ? potFromdB( dB - corr ) : potValue;
+        levelPot[ bin ] = value < 0 ? 0 : value;
+    }
+}
+
+
+// level in 0.1 dB at the output for FREQ word fw incl. the correction that the pot cannot compensate
+int16_t outputLevel( uint32_t fw ) {
+    if ( !gain )
+        return dB;
+    return dBfromValue( levelPot[ levelBin( fw ) ] ) + calCorrection( fw );
+}
+
+
+// calibration from EEPROM, defaults if not saved before
+void loadCal() {
+    uint8_t sum = calMagic;
+    for ( uint8_t i = 0; i < CALPOINTS; ++i ) {
+        calTable[ i ] = EEPROM.read( calAddr + 1 + i );
+        sum += calTable[ i ];
+    }
+    if ( EEPROM.read( calAddr ) != calMagic || EEPROM.read( calAddr + 1 + CALPOINTS ) != sum )
+        defaultCal();
+}
+
+
+void saveCal() {
+    uint8_t sum = calMagic;
+    EEPROM.update( calAddr, calMagic );
+    for ( uint8_t i = 0; i < CALPOINTS; ++i ) {
+        EEPROM.update( calAddr + 1 + i, calTable[ i ] );
+        sum += calTable[ i ];
+    }
+    EEPROM.update( calAddr + 1 + CALPOINTS, sum );
+}
+
+
+void defaultCal() {
+    for ( uint8_t i = 0; i < CALPOINTS; ++i )
+        calTable[ i ] = pgm_read_byte( calDefault + i );
+}
+
+
+// print the calibration points: index, kHz and level correction
+void showCal() {
+    for ( uint8_t i = 0; i < CALPOINTS; ++i ) {
+        halSerial.print( F( "cal " ) );
+        halSerial.print( i );
+        halSerial.print( F( ": " ) );
+        halSerial.print( ( ( uint32_t( i ) << CALSHIFT ) >> 16 ) * ( AD9833::MCLK / 1000 ) >> 12 ); // 32 bit, CALSHIFT >= 16
+        halSerial.print( F( " kHz " ) );
+        const int8_t c = calTable[ i ];
+        if ( c < 0 )
+            halSerial.write( '-' );
+        halSerial.print( abs( c ) / 10 );
+        halSerial.write( '.' );
+        halSerial.print( abs( c ) % 10 );
+        halSerial.println( F( " dB" ) );
+    }
+}
+
+
+uint16_t fletcher16( const uint8_t *data, uint8_t length ) {
+    uint8_t a = 0;
+    uint8_t b = 0;
+    while ( length-- ) {
+        a += *data++;
+        b += a;
     }
+    return ( b << 8 ) | a;
+}
+
+
+// the current settings as preset
+void getPreset( preset_t &p ) {
+    p.freqStart = freqStart;
+    p.freqStop = freqStop;
+    p.customSweep = customSweep;
+    p.waveType = waveType;
+    p.dB = dB;
+    p.gain = gain;
+    p.potValue = potValue;
+    p.dBtype = dBtype;
+    p.sweep = sweep;
+}
+
+
+uint32_t recordSequence( uint8_t record ) {
+    uint32_t seq = 0;
+    for ( uint8_t i = 4; i; --i )
+        seq = ( seq << 8 ) | EEPROM.read( record * recordSize + i );
+    return seq;
 }
 
 
 //-----------------------------------------------------------------------------
-// enterFreq
-//    transfer dataInput into freqStart
+// readRecord
+//   read the preset of a record, return its slot or presetCount if empty or invalid
 //-----------------------------------------------------------------------------
-void enterFreq() {
-    for ( uint8_t i = 0; i < numDigits; i++ ) {
-        freqStart[ i ] = dataInput[ i ];
+uint8_t readRecord( uint8_t record, preset_t &p ) {
+    const int addr = record * recordSize;
+    const uint8_t slot = EEPROM.read( addr );
+    if ( slot >= presetCount )
+        return presetCount;
+    uint8_t *data = (uint8_t *)&p;
+    for ( uint8_t i = 0; i < sizeof( p ); ++i )
+        data[ i ] = EEPROM.read( addr + 5 + i );
+    const uint16_t check = EEPROM.read( addr + 5 + sizeof( p ) ) | EEPROM.read( addr + 6 + sizeof( p ) ) << 8;
+    if ( check != fletcher16( data, sizeof( p ) ) || p.dBtype > dBV || p.sweep > swCustom || p.gain > 16 )
+        return presetCount;
+    return slot;
+}
+
+
+//-----------------------------------------------------------------------------
+// scanPresets
+//   find the newest valid record of each preset, live[ n ] = record or -1,
+//   return the newest record of all or -1 if there is none
+//-----------------------------------------------------------------------------
+int8_t scanPresets( int8_t *live ) {
+    uint32_t liveSeq[ presetCount ];
+    int8_t newest = -1;
+    uint32_t newestSeq = 0;
+    preset_t p;
+    for ( uint8_t n = 0; n < presetCount; ++n )
+        live[ n ] = -1;
+    for ( uint8_t r = 0; r < recordCount; ++r ) {
+        const uint8_t slot = readRecord( r, p );
+        if ( slot >= presetCount )
+            continue;
+        const uint32_t seq = recordSequence( r );
+        if ( live[ slot ] < 0 || seq > liveSeq[ slot ] ) {
+            live[ slot ] = r;
+            liveSeq[ slot ] = seq;
+        }
+        if ( newest < 0 || seq > newestSeq ) {
+            newest = r;
+            newestSeq = seq;
+        }
     }
+    return newest;
 }
 
 
 //-----------------------------------------------------------------------------
-// popFreq
-//    transfer freqStart back into dataInput
+// recallPreset
+//   load preset n, return false if it was not stored
+//   only the level bins are recalculated, sweepTask() writes the output
 //-----------------------------------------------------------------------------
-void popFreq() {
-    for ( uint8_t i = 0; i < numDigits; i++ ) {
-        dataInput[ i ] = freqStart[ i ];
+bool recallPreset( uint8_t n ) {
+    finishPreset();
+    int8_t live[ presetCount ];
+    scanPresets( live );
+    preset_t p;
+    if ( live[ n ] < 0 || readRecord( live[ n ], p ) != n )
+        return false;
+    HOP.stop();
+    freqStart = p.freqStart;
+    freqStop = p.freqStop;
+    customSweep = p.customSweep;
+    waveType = p.waveType;
+    dB = p.dB;
+    gain = p.gain;
+    potValue = p.potValue;
+    dBtype = dB_t( p.dBtype );
+    sweep = sweep_t( p.sweep );
+    updateLevel();
+    popFreq();
+    invalidate( wgAll );
+    if ( !n )
+        presetSaved = fletcher16( (const uint8_t *)&p, sizeof( p ) );
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// storePreset
+//   prepare a record of the current settings as preset n, presetTask() writes it
+//   the record goes to the next free place after the newest record
+//-----------------------------------------------------------------------------
+void storePreset( uint8_t n ) {
+    finishPreset();
+    int8_t live[ presetCount ];
+    int8_t record = scanPresets( live );
+    const uint32_t seq = record < 0 ? 0 : recordSequence( record ) + 1;
+    bool used;
+    do {
+        record = record + 1 < recordCount ? record + 1 : 0;
+        used = false;
+        for ( uint8_t i = 0; i < presetCount; ++i )
+            used |= live[ i ] == record;
+    } while ( used ); // there are more records than presets
+    preset_t p;
+    getPreset( p );
+    const uint16_t check = fletcher16( (const uint8_t *)&p, sizeof( p ) );
+    presetRecord[ 0 ] = n;
+    for ( uint8_t i = 0; i < 4; ++i )
+        presetRecord[ 1 + i ] = seq >> ( 8 * i );
+    memcpy( presetRecord + 5, &p, sizeof( p ) );
+    presetRecord[ 5 + sizeof( p ) ] = lowByte( check );
+    presetRecord[ 6 + sizeof( p ) ] = highByte( check );
+    presetAddr = record * recordSize;
+    presetStep = 0;
+    if ( !n )
+        presetSaved = check;
+}
+
+
+// write the pending record now ( blocking )
+void finishPreset() {
+    while ( presetStep <= recordSize )
+        writePresetByte();
+}
+
+
+//-----------------------------------------------------------------------------
+// writePresetByte
+//   write the next byte of presetRecord, waits if the EEPROM is busy
+//   the slot byte is marked empty first and written last,
+//   so an interrupted write leaves an empty record
+//-----------------------------------------------------------------------------
+void writePresetByte() {
+    if ( presetStep == 0 )
+        EEPROM.update( presetAddr, 0xFF );
+    else if ( presetStep < recordSize )
+        EEPROM.update( presetAddr + presetStep, presetRecord[ presetStep ] );
+    else
+        EEPROM.update( presetAddr, presetRecord[ 0 ] );
+    ++presetStep;
+}
+
+
+// pot value for a level in 0.1 dB, < 0: off, levels above full scale give 255
+int potFromdB( int value ) {
+    value = dBfullScale[ dBtype ] - value; // below full scale
+    if ( value < 0 )
+        return 255;
+    if ( value >= int( dB10Range ) )
+        return -1;
+    return pgm_read_byte( dB10ToPot + value );
+}
+
+
+void setdBGain( int value ) { setLinGain( potFromdB( value ) ); }
+
+
+//-----------------------------------------------------------------------------
+// addHop
+//    append a frequency with dwell time in ms and optional level ( 0.1 dB ) to the hop table
+//    register values are computed now for the current waveform and dB unit
+//    entries without level get the current level for their frequency when played
+//-----------------------------------------------------------------------------
+void addHop( const number_t &freq, long dwell, bool level, int dBlevel ) {
+    uint8_t flags = 0;
+    uint8_t pot = 0;
+    if ( freq.value > maxHz ) {
+        halSerial.println( F( "frequency out of range" ) );
+        return;
+    }
+    const uint32_t fw = AD9833::freqWord( freq.value, freq.milli );
+    if ( level ) {
+        int value = potFromdB( dBlevel - calCorrection( fw ) );
+        if ( value < 0 ) {
+            flags = HopTable::fLevel | HopTable::fOff;
+        } else {
+            if ( value > 255 )
+                value = 255;
+            if ( waveType == AD9833::wRectangle )
+                value /= 9; // see setPot()
+            flags = HopTable::fLevel;
+            pot = value;
+        }
     }
+    dwell = dwell * TICKRATE / 1000;
+    if ( dwell > 0xFFFF )
+        dwell = 0xFFFF;
+    if ( !HOP.add( fw, dwell, flags, pot ) )
+        halSerial.println( F( "hop table full" ) );
 }
 
 
 //-----------------------------------------------------------------------------
-// initSigGen
+// writeHop
+//    output a hop table entry, called from the timer1 interrupt
+//    SPI transactions of the main loop block this interrupt ( halSpiBegin() )
 //-----------------------------------------------------------------------------
-void initSigGen( void ) {
-    digitalWrite( AD_FSYNC, HIGH );
-    pinMode( AD_FSYNC, OUTPUT );
-    digitalWrite( MCP_CS, HIGH );
-    pinMode( MCP_CS, OUTPUT );
-    SPI.begin();
+void writeHop( const HopTable::Entry *e ) {
+    SpiBus::begin();
+    AD.setFreqWord( e->fw, waveType );
+    if ( e->flags & HopTable::fOff )
+        MCP.shutdown();
+    else if ( e->flags & HopTable::fLevel )
+        MCP.setPot( e->pot );
+    else if ( gain )
+        setPot( levelPot[ levelBin( e->fw ) ] );
+    SpiBus::end();
+}
 
-    setdBGain( 0 );
 
-    AD.reset();
+//-----------------------------------------------------------------------------
+// startModulation
+//    FSK: freq1 in FREQ0 for bit 0, freq2 in FREQ1 for bit 1
+//    PSK: freq1 with PHASE0 = 0 for bit 0, PHASE1 = modPhase for bit 1
+//    burst, gate: freq1, bit 0 stops MCLK and DAC ( SLEEP bits ), the phase
+//    continues where it stopped, so bursts of whole cycles start at the same phase
+//    the CONTROL words of both bits are calculated once, the symbol or gate
+//    interrupt writes one of them, a single SPI word per change
+//    burst timing: one symbol per cycle of freq1 ( Hz and mHz ) up to maxBaud,
+//    above the cycles are rounded to symbols of 1 / maxBaud
+//-----------------------------------------------------------------------------
+void startModulation() {
+    outputFw = freqStart.fw;
+    SpiBus::begin();
+    AD.setFreqWord( outputFw, waveType );
+    if ( modType == mdFsk )
+        AD.loadFreqWord( freqStop.fw );
+    AD.setPhaseWord( 0, 0 );
+    AD.setPhaseWord( 1, modType == mdPsk ? AD9833::phaseWord( modPhase ) : 0 );
+    refreshPot();
+    SpiBus::end();
+    const uint16_t control = AD.selectControl( 0, 0 );
+    switch ( modType ) {
+    case mdFsk:
+        MOD.start( control, AD.selectControl( 1, 0 ) );
+        halStartSymbols( modBaud, modSymbol );
+        break;
+    case mdPsk:
+        MOD.start( control, AD.selectControl( 0, 1 ) );
+        halStartSymbols( modBaud, modSymbol );
+        break;
+    case mdBurst: {
+        uint32_t rate = freqStart.hz;
+        uint16_t milliHz = freqStart.milliHz;
+        uint32_t on = burstOn;
+        uint32_t off = burstOff;
+        if ( rate > maxBaud ) { // the mHz are far below the rounding to 0.1 ms
+            on = ( on * maxBaud + rate / 2 ) / rate;
+            off = ( off * maxBaud + rate / 2 ) / rate;
+            if ( !on )
+                on = 1;
+            rate = maxBaud;
+            milliHz = 0;
+        }
+        MOD.startBurst( control | AD9833::wSleep, control, on, off );
+        halStartSymbols( rate, modSymbol, milliHz );
+        break;
+    }
+    case mdGate:
+        MOD.start( control | AD9833::wSleep, control );
+        halStartPinChange( gateChange );
+        noInterrupts(); // current level, an edge meanwhile is handled afterwards
+        gateChange();
+        interrupts();
+        break;
+    }
+    invalidate( wgSweep );
+}
+
+
+//-----------------------------------------------------------------------------
+// stopModulation
+//    stop the symbol interrupt, the output stays at the last symbol
+//    until the next frequency or waveform change
+//-----------------------------------------------------------------------------
+void stopModulation() {
+    if ( !MOD.running() )
+        return;
+    halStopSymbols();
+    halStopPinChange();
+    MOD.stop();
+    invalidate( wgSweep );
+}
+
+
+//-----------------------------------------------------------------------------
+// modSymbol
+//    output the next FSK / PSK / burst symbol, called from the timer1 compare B interrupt
+//    SPI transactions of the main loop block this interrupt ( halSpiBegin() )
+//-----------------------------------------------------------------------------
+void modSymbol() {
+    if ( MOD.running() )
+        AD.writeControl( MOD.symbol() );
+}
+
+
+//-----------------------------------------------------------------------------
+// gateChange
+//    switch the output on or off with the level of extIn, called from the
+//    pin change interrupt, latency from the edge: interrupt entry and one SPI word,
+//    up to the length of a running SPI transaction of the main loop more
+//-----------------------------------------------------------------------------
+void gateChange() {
+    if ( MOD.running() )
+        AD.writeControl( MOD.control( halExtInput() ) );
+}
+
 
-    if ( LOW == digitalRead( btnLeft ) ) {
-        cursor = 0;              // 10⁶ pos;
-        freqStart[ cursor ] = 1; // set 1MHz
-        freqStop[ cursor ] = 9;  // set 9MHz
-    } else if ( LOW == digitalRead( btnRight ) ) {
-        cursor = 1;                 // 10⁵ digit
-        freqStart[ cursor ] = 1;    // set 100 kHz
-        freqStop[ cursor - 1 ] = 1; // set 1MHz
-    } else if ( LOW == digitalRead( btnDown ) ) {
-        cursor = 2;                 // 10⁴ digit
-        freqStart[ cursor ] = 1;    // set 10 kHz
-        freqStop[ cursor - 1 ] = 1; // set 100kHz
-    } else if ( LOW == digitalRead( btnUp ) ) {
-        cursor = 3;                 // 10³ digit
-        freqStart[ cursor ] = 1;    // set 1 kHz
-        freqStop[ cursor - 1 ] = 2; // set 20kHz
+//-----------------------------------------------------------------------------
+// armTrigger
+//    prepare the sweep or hop table for the next trigger and switch the output
+//    off ( SLEEP bits ), triggerEdge() writes only the first value
+//    the sweep start value is loaded while the output sleeps, without sync pulse
+//-----------------------------------------------------------------------------
+void armTrigger() {
+    trigState = tsIdle; // edges meanwhile are missed
+    HOP.stop();
+    halDigitalWrite( testOut, LOW ); // sync pulse with the trigger
+    if ( trigMode == trSweep )
+        armSweep( true ); // start value in FREQ0, 2nd step preloaded
+    trigControl = AD.selectControl( 0, 0 ) & ~AD9833::wSleep;
+    AD.writeControl( trigControl | AD9833::wSleep );
+    trigState = tsArmed;
+}
+
+
+//-----------------------------------------------------------------------------
+// disarmTrigger
+//    back to free running, the caller restores the output
+//-----------------------------------------------------------------------------
+void disarmTrigger() {
+    if ( trigMode == trOff )
+        return;
+    halStopPinChange();
+    trigMode = trOff;
+    trigState = tsIdle;
+    HOP.stop();
+}
+
+
+//-----------------------------------------------------------------------------
+// triggerEdge
+//    start the armed sweep or hop table with a rising edge of extIn,
+//    called from the pin change interrupt
+//    latency from the edge to the first register write: interrupt entry and
+//    FSYNC, about 10 µs, up to the length of a running SPI transaction or
+//    tick interrupt more, the following steps or dwell times use the tick
+//    a pulse that ends before the interrupt runs is counted as missed
+//-----------------------------------------------------------------------------
+void triggerEdge() {
+    const bool high = halExtInput();
+    const bool pulse = !high && !trigLevel; // both edges before the interrupt
+    trigLevel = high;
+    if ( !high && !pulse ) // falling edge
+        return;
+    if ( pulse ) {
+        ++trigMissed;
+    } else if ( trigState == tsRunning ) {
+        ++trigEarly;
+    } else if ( trigState != tsArmed ) {
+        ++trigMissed;
+    } else {
+        trigState = tsRunning;
+        ++trigCount;
+        if ( trigMode == trSweep ) {
+            AD.writeControl( trigControl ); // output on, sweep start value
+            halDigitalWrite( testOut, HIGH );
+        } else {
+            const HopTable::Entry *e = HOP.trigger();
+            if ( e )
+                writeHop( e );
+        }
     }
-    popFreq(); // move into data input
+}
+
+
+//-----------------------------------------------------------------------------
+// armSweep
+//    get the profile of the selected sweep and calculate the register values,
+//    the step ratio or increment and the step timing once
+//    output the start value with sync pulse on testOut
+//    asleep: load the start value with the SLEEP bits set, no sync pulse,
+//    triggerEdge() switches the output on
+//-----------------------------------------------------------------------------
+void armSweep( bool asleep ) {
+    sweepProfile_t profile = { 0, 0, 0 };
+    switch ( sweep ) {
+    case sw1Sec:
+        profile.ms = 1000;
+        break;
+    case sw3Sec:
+        profile.ms = 3000;
+        break;
+    case sw10Sec:
+        profile.ms = 10000;
+        break;
+    case sw30Sec:
+        profile.ms = 30000;
+        break;
+    case swCustom:
+        profile = customSweep;
+        break;
+    default:
+        break;
+    }
+    bool logarithmic = !( profile.mode & spLinear );
+    bool triangle = profile.mode & spTriangle;
+    uint32_t ticks = profile.ms * TICKRATE / 1000;
+    if ( !ticks )
+        ticks = 1;
+    uint32_t maxSteps = triangle ? ticks : ticks - 1; // max. one step per tick
+    if ( maxSteps > 0xFFFF )
+        maxSteps = 0xFFFF;
+    uint16_t steps = profile.steps;
+    if ( !steps || steps > maxSteps )
+        steps = maxSteps;
+    sweepValues = triangle ? 2L * steps : steps + 1L;
+    sweepPeriod = triangle ? 2 * ticks : ticks;
+    sweepPhase = 0;
+    sweepStep = 0;
+    if ( profile.mode & spDown )
+        SW.arm( freqStop.fw, freqStart.fw, steps, logarithmic, triangle );
+    else
+        SW.arm( freqStart.fw, freqStop.fw, steps, logarithmic, triangle );
+    outputFw = SW.step();
+    const bool sync = SW.atStart();
+    sweepNext = SW.step();
+    SpiBus::begin();
+    AD.setFreqWord( outputFw, asleep ? waveType | AD9833::wSleep : waveType ); // output 1st step now
+    if ( !asleep )
+        halDigitalWrite( testOut, sync );
+    AD.loadFreqWord( sweepNext ); // and preload the 2nd step
+    refreshPot();
+    SpiBus::end();
+    sweepSync = SW.atStart();
+}
 
-    waveType = AD9833::wSine;
 
-    AD.setFrequency( calcNumber( freqStart ), waveType );
+//-----------------------------------------------------------------------------
+// stepSweep
+//    called every tick, advance the sweep when the next step is due
+//    steps are spread evenly with a phase accumulator ( Bresenham )
+//    only integer math, the sweep was prepared by armSweep()
+//    switch to the FREQ register preloaded before ( one SPI word )
+//    then preload the inactive register with the next step
+//    all in one SPI transaction, unchanged words and pot values are skipped
+//    testOut is high while the start value is output
+//-----------------------------------------------------------------------------
+void stepSweep() {
+    sweepPhase += sweepValues;
+    if ( sweepPhase < sweepPeriod )
+        return;
+    sweepPhase -= sweepPeriod;
+    if ( sweepSync && trigMode == trSweep ) { // one sweep per trigger
+        armTrigger();
+        return;
+    }
+    sweepStep = sweepSync ? 0 : sweepStep + 1;
+    SpiBus::begin();
+    AD.switchFreq();
+    halDigitalWrite( testOut, sweepSync );
+    outputFw = sweepNext;
+    refreshPot(); // leveled pot value of the new frequency
+    sweepNext = SW.step();
+    AD.loadFreqWord( sweepNext );
+    SpiBus::end();
+    sweepSync = SW.atStart();
 }
 
 
 //-----------------------------------------------------------------------------
-// myDelay
-//   delays for approx mS milliSeconds
-//   doesn't use any timers
-//   doesn't affect interrupts
+// exchgFreq
+//    exchange start and stop frequency
 //-----------------------------------------------------------------------------
-void myDelay( int mS ) {
-    for ( int j = 0; j < mS; j++ )
-        delayMicroseconds( 1000 );
+void exchgFreq() {
+    const freq_t x = freqStart;
+    freqStart = freqStop;
+    freqStop = x;
 }
 
 
 //-----------------------------------------------------------------------------
-// initTimer1
-// TIFR1 becomes non-zero after
-//    overflow * 64 / 16000000 sec
+// enterFreq
+//    transfer dataInput into freqStart
 //-----------------------------------------------------------------------------
+void enterFreq() {
+    setFreq( freqStart, dataInput.value, dataInput.milli );
+}
 
-void initTimer1( word overflow ) {
-    TCCR1A = 0x00; // Set OC1A on Compare Match
-    TCCR1B = 0x0B; // CTCmode, prescaler = 64 -> 250kHz
-    TCCR1C = 0x00; // no pwm output
-    OCR1AH = highByte( overflow );
-    OCR1AL = lowByte( overflow );
-    OCR1BH = 0;
-    OCR1BL = 0;
-    TIMSK1 = 0x00; // no interrupts
 
-    TCNT1H = 0;   // must be written first
-    TCNT1L = 0;   // clear the counter
-    TIFR1 = 0xFF; // clear all flags
+//-----------------------------------------------------------------------------
+// popFreq
+//    transfer freqStart back into dataInput
+//-----------------------------------------------------------------------------
+void popFreq() {
+    dataInput.value = freqStart.hz;
+    dataInput.milli = freqStart.milliHz;
 }
 
 
 //-----------------------------------------------------------------------------
-// configTimer2
-// output 50 kHz rectangele at D3 for a charge pump to create -5V for an op-amp
+// initSigGen
 //-----------------------------------------------------------------------------
-void initTimer2() {
-    // Initialize Timer2
-    TCCR2A = 0;
-    TCCR2B = 0;
-    TCNT2 = 0;
+void initSigGen( void ) {
+    halDigitalWrite( AD_FSYNC, HIGH );
+    halPinMode( AD_FSYNC, OUTPUT );
+    halDigitalWrite( MCP_CS, HIGH );
+    halPinMode( MCP_CS, OUTPUT );
+    halSpiBegin(); // SPI transactions block the interrupts ( writeHop(), modSymbol(), gateChange(), triggerEdge() )
+
+    loadCal();
+    setdBGain( 0 );
 
-    // Set OC2B for Compare Match (digital pin3)
-    pinMode( pwmOut, OUTPUT );
+    AD.partialUpdate = true; // write only the changed half of the FREQ register
+    AD.reset();
 
-    bitSet( TCCR2A, COM2B1 ); // clear OC2B on up count compare match
+    waveType = AD9833::wSine;
+    if ( LOW == halDigitalRead( btnLeft ) ) {
+        cursor = 0; // 10⁶ pos;
+        setFreq( freqStart, 1000000, 0 );
+        setFreq( freqStop, 9000000, 0 );
+    } else if ( LOW == halDigitalRead( btnRight ) ) {
+        cursor = 1; // 10⁵ digit
+        setFreq( freqStart, 100000, 0 );
+        setFreq( freqStop, 1000000, 0 );
+    } else if ( LOW == halDigitalRead( btnDown ) ) {
+        cursor = 2; // 10⁴ digit
+        setFreq( freqStart, 10000, 0 );
+        setFreq( freqStop, 100000, 0 );
+    } else if ( LOW == halDigitalRead( btnUp ) ) {
+        cursor = 3; // 10³ digit
+        setFreq( freqStart, 1000, 0 );
+        setFreq( freqStop, 20000, 0 );
+    } else {
+        recallPreset( 0 ); // state before power off
+    }
+    popFreq(); // move into data input
 
-    // Set mode 5 -> Phase correct PWM to OCR2A counts up and down
-    bitSet( TCCR2A, WGM20 );
-    bitSet( TCCR2B, WGM22 );
+    outputFw = freqStart.fw;
+    SpiBus::begin();
+    AD.setFreqWord( outputFw, waveType );
+    refreshPot();
+    SpiBus::end();
+}
 
-    // Set up prescaler to 001 = clk (16 MHz)
-    bitSet( TCCR2B, CS20 );
-    // bitSet(TCCR2B, CS21);
-    // bitSet(TCCR2B, CS22);
 
-    OCR2A = 160; // Sets t = 10 µs up + 10 µs down -> freq = 50 kHz
-    OCR2B = 80;  // 50% duty cycle, valid values: 0 (permanent low), 1..159, 160 (permanent high)
+//-----------------------------------------------------------------------------
+// timerTick
+//   called TICKRATE times per second from the timer interrupt
+//-----------------------------------------------------------------------------
+void timerTick() {
+    SCH.tick();
+    const HopTable::Entry *e = HOP.tick();
+    if ( e )
+        writeHop( e );
 }
 
 
 void initButtons() {
-    pinMode( btnLeft, INPUT_PULLUP );
-    pinMode( btnRight, INPUT_PULLUP );
-    pinMode( btnUp, INPUT_PULLUP );
-    pinMode( btnDown, INPUT_PULLUP );
-    pinMode( testOut, OUTPUT );
+    keyLeft.begin();
+    keyRight.begin();
+    keyUp.begin();
+    keyDown.begin();
+    halPinMode( testOut, OUTPUT );
+    halPinMode( extIn, INPUT_PULLUP );
 }
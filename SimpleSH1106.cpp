@@ -4,12 +4,11 @@
 ***************************************************/
 
 #include <avr/pgmspace.h>
-#include <Wire.h>
 
 #include "SimpleSH1106.h"
 
 
-SimpleSH1106::SimpleSH1106( uint8_t i2c ) : addrI2C( i2c ) {
+SimpleSH1106::SimpleSH1106( uint8_t i2c ) : addrI2C( i2c ), barCol( 0 ), barPage( 0 ), barCount( 0 ) {
 }
 
 //==============================================================
@@ -29,47 +28,173 @@ SimpleSH1106::SimpleSH1106( uint8_t i2c ) : addrI2C( i2c ) {
 //
 //==============================================================
 void SimpleSH1106::init() {
-    Wire.begin(); // join i2c bus as master
-    TWBR = 4; // freq=666kHz period=1.500uS
-    Wire.endTransmission();
-    Wire.beginTransmission( addrI2C );
-    Wire.write( 0x00 ); // the following bytes are commands
-    Wire.write( 0xAE ); // display off
-    Wire.write( 0xD5 ); Wire.write( 0x80 ); // clock divider
-    Wire.write( 0xA8 ); Wire.write( 0x3F ); // multiplex ratio ( height - 1 )
-    Wire.write( 0xD3 ); Wire.write( 0x00 ); // no display offset
-    Wire.write( 0x40 ); // start line address=0
-    Wire.write( 0x33 ); // charge pump max
-    Wire.write( 0x8D ); Wire.write( 0x14 ); // enable charge pump
-    Wire.write( 0x20 ); Wire.write( 0x02 ); // memory adressing mode=horizontal ( only for 1306?? ) maybe 0x00
-    Wire.write( 0xA1 ); // segment remapping mode
-    Wire.write( 0xC8 ); // COM output scan direction
-    Wire.write( 0xDA ); Wire.write( 0x12 );   // com pins hardware configuration
-    Wire.write( 0x81 ); Wire.write( 0xFF ); // contrast control // could be 0x81
-    Wire.write( 0xD9 ); Wire.write( 0xF1 ); // pre-charge period or 0x22
-    Wire.write( 0xDB ); Wire.write( 0x40 ); // set vcomh deselect level or 0x20
-    Wire.write( 0xA4 ); // output RAM to display
-    Wire.write( 0xA6 ); // display mode A6=normal, A7=inverse
-    Wire.write( 0x2E ); // stop scrolling
-    Wire.write( 0xAF ); // display on
-    Wire.endTransmission();
+    TwiQ.begin( 4 ); // freq=666kHz period=1.500uS
+    beginI2C();
+    writeI2C( 0x00 ); // the following bytes are commands
+    writeI2C( 0xAE ); // display off
+    writeI2C( 0xD5 ); writeI2C( 0x80 ); // clock divider
+    writeI2C( 0xA8 ); writeI2C( 0x3F ); // multiplex ratio ( height - 1 )
+    writeI2C( 0xD3 ); writeI2C( 0x00 ); // no display offset
+    writeI2C( 0x40 ); // start line address=0
+    writeI2C( 0x33 ); // charge pump max
+    writeI2C( 0x8D ); writeI2C( 0x14 ); // enable charge pump
+    writeI2C( 0x20 ); writeI2C( 0x02 ); // memory adressing mode=horizontal ( only for 1306?? ) maybe 0x00
+    writeI2C( 0xA1 ); // segment remapping mode
+    writeI2C( 0xC8 ); // COM output scan direction
+    writeI2C( 0xDA ); writeI2C( 0x12 );   // com pins hardware configuration
+    writeI2C( 0x81 ); writeI2C( 0xFF ); // contrast control // could be 0x81
+    writeI2C( 0xD9 ); writeI2C( 0xF1 ); // pre-charge period or 0x22
+    writeI2C( 0xDB ); writeI2C( 0x40 ); // set vcomh deselect level or 0x20
+    writeI2C( 0xA4 ); // output RAM to display
+    writeI2C( 0xA6 ); // display mode A6=normal, A7=inverse
+    writeI2C( 0x2E ); // stop scrolling
+    writeI2C( 0xAF ); // display on
+    endI2C();
     clearScreen();
+    while ( !flush() ) // wait until all is queued
+        ;
 }
 
 
 //==============================================================
 // clearScreen
 //   fills the screen with zeros
+//   with framebuffer: the display content is unknown,
+//   clear the buffer and mark all as changed
 //==============================================================
 void SimpleSH1106::clearScreen() {
-    uint8_t col, page;
-    const int n = 26;
+    uint8_t page;
+#if SH1106_FRAMEBUFFER
+    for ( page = 0; page < PAGES; page++ ) {
+        for ( uint8_t col = 0; col < COLUMNS; col++ )
+            frameBuffer[ page ][ col ] = 0;
+        for ( uint8_t i = 0; i < COLUMNS / 8; i++ )
+            fillBits[ page ][ i ] = 0;
+        dirtyFirst[ page ] = 0;
+        dirtyLast[ page ] = COLUMNS - 1;
+    }
+#else
     for ( page = 0; page < PAGES; page++ )
-        for ( col = 0; col < COLUMNS; col++ ) {
-            if ( col % n == 0 ) setupColPage( col, page );
-            Wire.write( 0 );
-            if ( ( col % n == n - 1 ) || ( col == COLUMNS - 1 ) ) Wire.endTransmission();
+        fillBars( 0, page, COLUMNS, 0 );
+#endif
+}
+
+
+//==============================================================
+// fillBars
+//   fill count bars from col, page with bar
+//   with framebuffer the fill is done by flush() for all bars
+//   that were not drawn in the meantime, so clearing an area
+//   and drawing the same content again sends nothing
+//==============================================================
+void SimpleSH1106::fillBars( uint8_t col, uint8_t page, uint8_t count, uint8_t bar ) {
+#if SH1106_FRAMEBUFFER
+    if ( page >= PAGES )
+        return;
+    if ( bar != fillBar[ page ] ) { // only one fill value per page
+        applyFill( page );
+        fillBar[ page ] = bar;
+    }
+    for ( ; count && col < COLUMNS; --count, ++col )
+        fillBits[ page ][ col / 8 ] |= 1 << ( col % 8 );
+#else
+    startBars( col, page );
+    while ( count-- )
+        putBar( bar );
+    endBars();
+#endif
+}
+
+
+#if SH1106_FRAMEBUFFER
+//==============================================================
+// applyFill
+//   do the pending fills of this page in the framebuffer
+//==============================================================
+void SimpleSH1106::applyFill( uint8_t page ) {
+    for ( uint8_t i = 0; i < COLUMNS / 8; i++ ) {
+        uint8_t bits = fillBits[ page ][ i ];
+        if ( !bits )
+            continue;
+        fillBits[ page ][ i ] = 0;
+        for ( uint8_t col = 8 * i; bits; bits >>= 1, col++ )
+            if ( bits & 1 ) {
+                barCol = col;
+                barPage = page;
+                putBar( fillBar[ page ] );
+            }
+    }
+}
+#endif
+
+
+//==============================================================
+// flush
+//   send all changed columns of the framebuffer to the display
+//   one span per page in bursts of max. BURST bytes
+//   stops when the I2C queue is full, the rest stays marked
+//   returns true if all changes are queued
+//   no-op without framebuffer
+//==============================================================
+bool SimpleSH1106::flush() {
+#if SH1106_FRAMEBUFFER
+    for ( uint8_t page = 0; page < PAGES; page++ ) {
+        applyFill( page );
+        uint8_t last = dirtyLast[ page ];
+        for ( uint8_t col = dirtyFirst[ page ]; col <= last; col += BURST ) {
+            uint8_t n = last - col + 1;
+            if ( n > BURST )
+                n = BURST;
+            if ( TwiQ.space() < n + 9 ) { // 2 packets: setup ( 2 + 4 ) and data ( 2 + 1 + n )
+                dirtyFirst[ page ] = col;  // continue here next time
+                return false;
+            }
+            setupColPage( col, page );
+            for ( uint8_t i = 0; i < n; i++ )
+                writeI2C( frameBuffer[ page ][ col + i ] );
+            endI2C();
         }
+        dirtyFirst[ page ] = COLUMNS; // mark as unchanged
+        dirtyLast[ page ] = 0;
+    }
+#endif
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// drawFrame
+//   draws a box around the screen and clears the inside
+//-----------------------------------------------------------------------------
+void SimpleSH1106::drawFrame() {
+    for ( uint8_t page = 0; page < PAGES; ++page ) {
+        drawFrame( page, 0 );
+        drawFrame( page, 1 );
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// drawFrame
+//   draws the left ( half 0 ) or right half of one page of the box
+//   and clears the inside
+//-----------------------------------------------------------------------------
+void SimpleSH1106::drawFrame( uint8_t page, uint8_t half ) {
+    uint8_t line = 0;  // inside
+    uint8_t edge = 255;
+    if ( page == 0 ) { // top line
+        line = 8;
+        edge = 248;
+    } else if ( page == PAGES - 1 ) { // bottom line
+        line = 128;
+    }
+    if ( half == 0 ) {
+        drawBar( 0, page, edge );
+        fillBars( 1, page, COLUMNS / 2 - 1, line );
+    } else {
+        fillBars( COLUMNS / 2, page, COLUMNS / 2 - 1, line );
+        drawBar( COLUMNS - 1, page, edge );
+    }
 }
 
 
@@ -78,11 +203,8 @@ void SimpleSH1106::clearScreen() {
 //   draws a box around the screen with "text" written at top-left
 //-----------------------------------------------------------------------------
 void SimpleSH1106::drawBox( const char* text ) {
-    drawImage( 0, 0, imgBoxTop );
-    for ( uint8_t page = 1; page < PAGES - 1; ++page )
-        drawImage( 0, page, imgBoxMid );
-    drawImage( 0, PAGES - 1, imgBoxBot );
-    drawChar( ' ',  6, 0, smallFont );
+    drawFrame();
+    drawBar( 6, 0, 0 ); // gap before text
     drawString( text,  7, 0, smallFont );
 }
 
@@ -92,32 +214,43 @@ void SimpleSH1106::drawBox( const char* text ) {
 //   draws a box around the screen with "text" written at top-left
 //-----------------------------------------------------------------------------
 void SimpleSH1106::drawBox( const __FlashStringHelper* text ) {
-    drawImage( 0, 0, imgBoxTop );
-    for ( int page = 1; page < PAGES - 1; ++page )
-        drawImage( 0, page, imgBoxMid );
-    drawImage( 0, PAGES - 1, imgBoxBot );
-    drawChar( ' ',  6, 0, smallFont );
+    drawFrame();
+    drawBar( 6, 0, 0 ); // gap before text
     drawString( text,  7, 0, smallFont );
 }
 
 
+//-----------------------------------------------------------------------------
+// drawBox with text from Flash via F("text"), one part
+//   draws the box in BOX_PARTS steps: the page halves, then the text
+//-----------------------------------------------------------------------------
+void SimpleSH1106::drawBox( const __FlashStringHelper* text, uint8_t part ) {
+    if ( part < 2 * PAGES ) {
+        drawFrame( part / 2, part % 2 );
+    } else {
+        drawBar( 6, 0, 0 ); // gap before text
+        drawString( text,  7, 0, smallFont );
+    }
+}
+
+
 //==============================================================
 // setupColPage
 //   sets up the column and row
 //   then gets ready to send one or more bytes
-//   should be followed by endTransmission
+//   should be followed by endI2C
 //==============================================================
 void SimpleSH1106::setupColPage( uint8_t col, uint8_t page ) {
     col += colOffset;
-    Wire.beginTransmission( addrI2C );
-    Wire.write( 0x00 ); // the following bytes are commands
-    Wire.write( 0xB0 + page ); // set page
-    Wire.write( 0x00 + ( col & 15 ) ); // lower columns address
-    Wire.write( 0x10 + ( col >> 4 ) ); // upper columns address
-    Wire.endTransmission();
-
-    Wire.beginTransmission( addrI2C );
-    Wire.write( 0x40 ); // the following bytes are data
+    beginI2C();
+    writeI2C( 0x00 ); // the following bytes are commands
+    writeI2C( 0xB0 + page ); // set page
+    writeI2C( 0x00 + ( col & 15 ) ); // lower columns address
+    writeI2C( 0x10 + ( col >> 4 ) ); // upper columns address
+    endI2C();
+
+    beginI2C();
+    writeI2C( 0x40 ); // the following bytes are data
 }
 
 
@@ -127,11 +260,11 @@ void SimpleSH1106::setupColPage( uint8_t col, uint8_t page ) {
 //==============================================================
 void SimpleSH1106::setupCol( uint8_t col ) {
     col += colOffset;
-    Wire.beginTransmission( addrI2C );
-    Wire.write( 0x00 ); // the following bytes are commands
-    Wire.write( 0x00 + ( col & 15 ) ); // lower columns address
-    Wire.write( 0x10 + ( col >> 4 ) ); // upper columns address
-    Wire.endTransmission();
+    beginI2C();
+    writeI2C( 0x00 ); // the following bytes are commands
+    writeI2C( 0x00 + ( col & 15 ) ); // lower columns address
+    writeI2C( 0x10 + ( col >> 4 ) ); // upper columns address
+    endI2C();
 }
 
 
@@ -140,10 +273,85 @@ void SimpleSH1106::setupCol( uint8_t col ) {
 //   sets up the page
 //==============================================================
 void SimpleSH1106::setupPage( uint8_t page ) {
-    Wire.beginTransmission( addrI2C );
-    Wire.write( 0x00 ); // the following bytes are commands
-    Wire.write( 0xB0 + page ); // set page
-    Wire.endTransmission();
+    beginI2C();
+    writeI2C( 0x00 ); // the following bytes are commands
+    writeI2C( 0xB0 + page ); // set page
+    endI2C();
+}
+
+
+//==============================================================
+// beginI2C, writeI2C, endI2C
+//   queue one I2C transmission and count the bytes on the bus
+//   without framebuffer wait until the queue can take a transmission
+//   of max. size, flush() checks the space itself
+//==============================================================
+void SimpleSH1106::beginI2C() {
+#if !SH1106_FRAMEBUFFER
+    while ( TwiQ.space() < BURST + 3 )
+        ;
+#endif
+    TwiQ.beginPacket( addrI2C );
+    ++byteCount; // address byte
+}
+
+
+void SimpleSH1106::writeI2C( uint8_t data ) {
+    TwiQ.write( data );
+    ++byteCount;
+}
+
+
+void SimpleSH1106::endI2C() {
+    TwiQ.endPacket();
+}
+
+
+//==============================================================
+// startBars, putBar, endBars
+//   draw a horizontal run of bars starting at col, page
+//   with framebuffer: write into the buffer, mark changed columns
+//   without: send to the display, restart the transmission after BURST bars
+//==============================================================
+void SimpleSH1106::startBars( uint8_t col, uint8_t page ) {
+    barCol = col;
+    barPage = page;
+    barCount = 0;
+#if !SH1106_FRAMEBUFFER
+    setupColPage( col, page );
+#endif
+}
+
+
+void SimpleSH1106::putBar( uint8_t bar ) {
+#if SH1106_FRAMEBUFFER
+    if ( barCol < COLUMNS && barPage < PAGES ) {
+        fillBits[ barPage ][ barCol / 8 ] &= ~( 1 << ( barCol % 8 ) ); // drawn, no fill
+        if ( frameBuffer[ barPage ][ barCol ] != bar ) {
+            frameBuffer[ barPage ][ barCol ] = bar;
+            if ( barCol < dirtyFirst[ barPage ] )
+                dirtyFirst[ barPage ] = barCol;
+            if ( barCol > dirtyLast[ barPage ] )
+                dirtyLast[ barPage ] = barCol;
+        }
+    }
+#else
+    if ( barCount >= BURST ) {
+        endI2C();
+        setupColPage( barCol, barPage );
+        barCount = 0;
+    }
+    writeI2C( bar );
+    ++barCount;
+#endif
+    ++barCol;
+}
+
+
+void SimpleSH1106::endBars() {
+#if !SH1106_FRAMEBUFFER
+    endI2C();
+#endif
 }
 
 
@@ -151,13 +359,10 @@ void SimpleSH1106::setupPage( uint8_t page ) {
 // drawBar
 //   draws a single bar
 //   a 'bar' is a byte on the screen - a col of 8 pix, LSB top
-//   assumes you've set up the page and col
+//   assumes you've set up the page and col with startBars
 //==============================================================
 void SimpleSH1106::drawBar( uint8_t bar ) {
-    Wire.beginTransmission( addrI2C );
-    Wire.write( 0x40 ); // the following bytes are data
-    Wire.write( bar );
-    Wire.endTransmission();
+    putBar( bar );
 }
 
 
@@ -165,12 +370,12 @@ void SimpleSH1106::drawBar( uint8_t bar ) {
 // drawBar
 //   draws a bar at col, page
 //   sets up the row and column then sends the byte
-//   quite slow
+//   quite slow without framebuffer
 //==============================================================
 void SimpleSH1106::drawBar( uint8_t col, uint8_t page, uint8_t bar ) {
-    setupColPage( col, page );
-    Wire.write( bar );
-    Wire.endTransmission();
+    startBars( col, page );
+    putBar( bar );
+    endBars();
 }
 
 
@@ -181,19 +386,16 @@ void SimpleSH1106::drawBar( uint8_t col, uint8_t page, uint8_t bar ) {
 //   returns width of image
 //==============================================================
 uint8_t SimpleSH1106::drawImage( uint8_t col, uint8_t page, const uint8_t *bitmap ) {
-    static uint8_t n = 0;
 
 #define drawNextBar( bar ) {\
         if ( ( ap < PAGES ) && ( ac < COLUMNS ) ) {\
-            n++;\
-            if ( ( ap != curpage ) || ( n > 25 ) ){\
+            if ( ap != curpage ) {\
                 if ( curpage < PAGES ) \
-                    Wire.endTransmission();\
-                setupColPage( ac, ap );\
+                    endBars();\
+                startBars( ac, ap );\
                 curpage = ap;\
-                n = 0;\
             }\
-            Wire.write( bar );\
+            putBar( bar );\
         }  \
         ac++;\
         if ( ac > col + width - 1 ) {\
@@ -224,7 +426,8 @@ uint8_t SimpleSH1106::drawImage( uint8_t col, uint8_t page, const uint8_t *bitma
             }
         }
     }
-    Wire.endTransmission();
+    if ( curpage < PAGES )
+        endBars();
 
     return width;
 }
@@ -234,54 +437,57 @@ uint8_t SimpleSH1106::drawImage( uint8_t col, uint8_t page, const uint8_t *bitma
 // drawChar
 //   draws a char at col, page
 //   only 8-bit or less fonts are allowed
-//   returns width of char + 1 ( letter_gap )
+//   the glyph is found with the index of the font
+//   returns width of char + letter_gap
 //==============================================================
-uint8_t SimpleSH1106::drawChar( uint8_t c, uint8_t col, uint8_t page, const uint8_t *font ) {
-    uint8_t n, i, j, h, result, b, prevB;
-    result = 0;
-    prevB = 0;
-    j  =  pgm_read_byte_near( font ); // first char
-    font++;
-    if ( c < j ) return 0;
-
-    h  =  pgm_read_byte_near( font ); // height in pages must be 1 or 2
-    font++;
-
-    while ( c > j ) {
-        b  =  pgm_read_byte_near( font );
-        font++;
-        if ( b == 0 ) return 0;
-        font += b * h;
-        c--;
+uint8_t SimpleSH1106::drawChar( uint8_t c, uint8_t col, uint8_t page, const Font &font ) {
+    uint8_t result = 0;
+    if ( uint8_t( c - font.first ) >= font.count ) return 0;
+    for ( uint8_t row = 0; row < font.height; row++ ) {
+        startBars( col, page + row );
+        result = putChar( c, row, font );
+        endBars();
     }
+    return result;
+}
 
-    n  =  pgm_read_byte_near( font );
-    font++;
-    result = n + h; // letter_gap
-
-    while ( h > 0 ) {
-        setupColPage( col, page );
-        for ( i = 0; i < n; i++ ) {
-            b  =  pgm_read_byte_near( font );
-            font++;
-            if ( bold )
-                Wire.write( b | prevB );
-            else
-                Wire.write( b );
-            prevB = b;
-        }
-
-        if ( bold ) {
-            Wire.write( prevB );
-            result++;
-        }
 
-        Wire.write( 0 );
+//==============================================================
+// putChar
+//   puts the bars of one page ( row ) of a char
+//   and the letter_gap of font height bars, so a char
+//   can be drawn over another one without clearing
+//   assumes you've set up the page and col with startBars
+//   returns width of char + letter_gap
+//==============================================================
+uint8_t SimpleSH1106::putChar( uint8_t c, uint8_t row, const Font &font ) {
+    uint8_t n, i, result, b, prevB;
+    prevB = 0;
+    c -= font.first; // wraps around for c < first
+    if ( c >= font.count ) return 0;
+    const uint8_t *glyph = font.glyphs + pgm_read_word_near( font.index + c );
+
+    n  =  pgm_read_byte_near( glyph );
+    glyph += 1 + row * n;
+    result = n + font.height; // letter_gap
+
+    for ( i = 0; i < n; i++ ) {
+        b  =  pgm_read_byte_near( glyph );
+        glyph++;
+        if ( bold )
+            putBar( b | prevB );
+        else
+            putBar( b );
+        prevB = b;
+    }
 
-        h--;
-        page++;
-        Wire.endTransmission();
+    if ( bold ) {
+        putBar( prevB );
+        result++;
     }
+
+    for ( i = 0; i < font.height; i++ )
+        putBar( 0 );
     return result;
 }
 
@@ -289,15 +495,24 @@ uint8_t SimpleSH1106::drawChar( uint8_t c, uint8_t col, uint8_t page, const uint
 //==============================================================
 // drawString
 //   draws a string at col, page
+//   single page fonts in one run of bars
 //   returns width drawn
 //==============================================================
-uint8_t SimpleSH1106::drawString( const char *s, uint8_t col, uint8_t page, const uint8_t *font ) {
+uint8_t SimpleSH1106::drawString( const char *s, uint8_t col, uint8_t page, const Font &font ) {
     uint8_t start = col;
-    if ( page <= 7 )
-        while ( *s ) {
-            col += drawChar( *s, col, page, font );
-            s++;
+    if ( page <= 7 ) {
+        if ( font.height == 1 ) {
+            startBars( col, page );
+            while ( *s )
+                col += putChar( *s++, 0, font );
+            endBars();
+        } else {
+            while ( *s ) {
+                col += drawChar( *s, col, page, font );
+                s++;
+            }
         }
+    }
     return col - start;
 }
 
@@ -305,15 +520,24 @@ uint8_t SimpleSH1106::drawString( const char *s, uint8_t col, uint8_t page, cons
 //==============================================================
 // drawString (from Flash)
 //   draws a string at col, page
+//   single page fonts in one run of bars
 //   returns width drawn
 //==============================================================
-uint8_t SimpleSH1106::drawString( const __FlashStringHelper *f, uint8_t col, uint8_t page, const uint8_t *font ) {
+uint8_t SimpleSH1106::drawString( const __FlashStringHelper *f, uint8_t col, uint8_t page, const Font &font ) {
     uint8_t start = col;
     PGM_P p = reinterpret_cast<PGM_P>( f );
     char c;
-    if ( page <= 7 )
-        while ( ( c = pgm_read_byte( p++ ) ) )
-            col += drawChar( c, col, page, font );
+    if ( page <= 7 ) {
+        if ( font.height == 1 ) {
+            startBars( col, page );
+            while ( ( c = pgm_read_byte( p++ ) ) )
+                col += putChar( c, 0, font );
+            endBars();
+        } else {
+            while ( ( c = pgm_read_byte( p++ ) ) )
+                col += drawChar( c, col, page, font );
+        }
+    }
     return col - start;
 }
 
@@ -321,29 +545,34 @@ uint8_t SimpleSH1106::drawString( const __FlashStringHelper *f, uint8_t col, uin
 //==============================================================
 // drawInt
 //   draws an int at col, page
+//   digits by subtracting powers of ten, no long division
 //   returns width drawn
 //==============================================================
-uint8_t SimpleSH1106::drawInt( long i, uint8_t col, uint8_t page, const uint8_t *font ) {
+uint8_t SimpleSH1106::drawInt( long i, uint8_t col, uint8_t page, const Font &font ) {
+    static const uint32_t powers[] PROGMEM = { 1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL };
     uint8_t start = col;
+    uint32_t u = i;
     if ( i < 0 ) {
-        i = -i;
+        u = -u;
         col += drawChar( '-', col, page, font );
     }
 
-    bool hasDigit = false;
-    long n =  1000000000L;
-    if ( i == 0 ) {
-        col += drawChar( '0', col, page, font );
-    } else {
-        while ( n > 0 ) {
-            if ( ( i >= n ) or hasDigit ) {
-                col += drawChar( '0' + ( i / n ), col, page, font );
-                hasDigit = true;
+    if ( u >= 10 ) { // single digits ( the usual case ) need no loop
+        bool hasDigit = false;
+        for ( uint8_t p = 0; p < sizeof( powers ) / sizeof( powers[ 0 ] ); ++p ) {
+            const uint32_t power = pgm_read_dword( powers + p );
+            if ( u < power && !hasDigit )
+                continue;
+            char digit = '0';
+            while ( u >= power ) {
+                u -= power;
+                ++digit;
             }
-            i %= n;
-            n /= 10;
+            col += drawChar( digit, col, page, font );
+            hasDigit = true;
         }
     }
+    col += drawChar( '0' + u, col, page, font );
     return col - start;
 }
 
@@ -351,9 +580,21 @@ uint8_t SimpleSH1106::drawInt( long i, uint8_t col, uint8_t page, const uint8_t
 
 //==============================================================
 // font definitons
+//   glyphs: first char, height in pages, { width, width * height bytes } ..., 0
+//   the index with the offset of each glyph is calculated by the compiler
 //==============================================================
 //
-const uint8_t SimpleSH1106::smallFont[] = {
+
+// offset of glyph n, starting with the 1st glyph at offset 2
+static constexpr uint16_t glyphOffset( const uint8_t *glyphs, uint8_t n, uint16_t offset = 2 ) {
+    return n ? glyphOffset( glyphs, n - 1, offset + 1 + glyphs[ offset ] * glyphs[ 1 ] ) : offset;
+}
+
+#define GLYPHS4( g, n ) glyphOffset( g, n ), glyphOffset( g, n + 1 ), glyphOffset( g, n + 2 ), glyphOffset( g, n + 3 )
+#define GLYPHS16( g, n ) GLYPHS4( g, n ), GLYPHS4( g, n + 4 ), GLYPHS4( g, n + 8 ), GLYPHS4( g, n + 12 )
+
+
+static constexpr uint8_t smallGlyphs[] PROGMEM = {
     ' ', // first char
     1,   // height in pages
     4, 0x00, 0x00, 0x00, 0x00, // <space>
@@ -455,9 +696,19 @@ const uint8_t SimpleSH1106::smallFont[] = {
     0
 };
 
+static const uint16_t smallIndex[] PROGMEM = {
+    GLYPHS16( smallGlyphs, 0 ), GLYPHS16( smallGlyphs, 16 ), GLYPHS16( smallGlyphs, 32 ),
+    GLYPHS16( smallGlyphs, 48 ), GLYPHS16( smallGlyphs, 64 ), GLYPHS16( smallGlyphs, 80 )
+};
+static_assert( smallGlyphs[ glyphOffset( smallGlyphs, sizeof( smallIndex ) / 2 ) ] == 0, "smallIndex does not match the glyphs" );
+
+const SimpleSH1106::Font SimpleSH1106::smallFont = {
+    smallGlyphs, smallIndex, smallGlyphs[ 0 ], sizeof( smallIndex ) / 2, smallGlyphs[ 1 ]
+};
+
 
 #if 0
-const uint8_t SimpleSH1106::smallDigitsFont[] = {
+static constexpr uint8_t smallDigitsGlyphs[] PROGMEM = {
     '+', //first char
     1,   // height in pages
     3, 0x10, 0x38, 0x10,       // +
@@ -477,10 +728,19 @@ const uint8_t SimpleSH1106::smallDigitsFont[] = {
     4, 0x26, 0x49, 0x49, 0x3E, // 9
     0
 };
+
+static const uint16_t smallDigitsIndex[] PROGMEM = {
+    GLYPHS4( smallDigitsGlyphs, 0 ), GLYPHS4( smallDigitsGlyphs, 4 ), GLYPHS4( smallDigitsGlyphs, 8 ),
+    glyphOffset( smallDigitsGlyphs, 12 ), glyphOffset( smallDigitsGlyphs, 13 ), glyphOffset( smallDigitsGlyphs, 14 )
+};
+
+const SimpleSH1106::Font SimpleSH1106::smallDigitsFont = {
+    smallDigitsGlyphs, smallDigitsIndex, smallDigitsGlyphs[ 0 ], sizeof( smallDigitsIndex ) / 2, smallDigitsGlyphs[ 1 ]
+};
 #endif
 
 
-const uint8_t SimpleSH1106::largeDigitsFont[] = {
+static constexpr uint8_t largeDigitsGlyphs[] PROGMEM = {
     '+', // first char
     2,   // height in pages
     12, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x06, 0x06, 0x06, 0xFF, 0xFF, 0x06, 0x06, 0x06, 0x06, 0x06, // +
@@ -501,6 +761,16 @@ const uint8_t SimpleSH1106::largeDigitsFont[] = {
     0
 };
 
+static const uint16_t largeDigitsIndex[] PROGMEM = {
+    GLYPHS4( largeDigitsGlyphs, 0 ), GLYPHS4( largeDigitsGlyphs, 4 ), GLYPHS4( largeDigitsGlyphs, 8 ),
+    glyphOffset( largeDigitsGlyphs, 12 ), glyphOffset( largeDigitsGlyphs, 13 ), glyphOffset( largeDigitsGlyphs, 14 )
+};
+static_assert( largeDigitsGlyphs[ glyphOffset( largeDigitsGlyphs, sizeof( largeDigitsIndex ) / 2 ) ] == 0, "largeDigitsIndex does not match the glyphs" );
+
+const SimpleSH1106::Font SimpleSH1106::largeDigitsFont = {
+    largeDigitsGlyphs, largeDigitsIndex, largeDigitsGlyphs[ 0 ], sizeof( largeDigitsIndex ) / 2, largeDigitsGlyphs[ 1 ]
+};
+
 
 const uint8_t SimpleSH1106::imgSmiley[] = {
     21, // width
@@ -508,30 +778,3 @@ const uint8_t SimpleSH1106::imgSmiley[] = {
     4, 0, 192, 48, 8, 130, 4, 130, 130, 133, 1, 130, 130, 130, 4, 7, 8, 48, 192, 0, 31, 96, 128, 130, 0, 1, 67, 130, 132, 1, 3, 131, 0,
     1, 3, 130, 132, 1, 67, 130, 0, 3, 128, 96, 31, 130, 0, 2, 1, 2, 130, 4, 130, 8, 133, 17, 130, 8, 130, 4, 2, 2, 1, 130, 0
 };
-
-
-const uint8_t SimpleSH1106::imgBoxTop[] = {
-    128, // width
-    1,   // pages
-    1, 248,
-    128 + 126, 8,
-    1, 248,
-};
-
-
-const uint8_t SimpleSH1106::imgBoxMid[] = {
-    128, // width
-    1,   // pages
-    1, 255,
-    128 + 126, 0,
-    1, 255,
-};
-
-
-const uint8_t SimpleSH1106::imgBoxBot[] = {
-    128, // width
-    1,   // pages
-    1, 255,
-    128 + 126, 128,
-    1, 255,
-};
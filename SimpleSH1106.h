@@ -7,44 +7,88 @@
       SimpleSH1106 SH1106;
       SH1106.init();
       SH1106.drawImage( 20, 1, imgSmiley );
+      SH1106.flush();
+
+    Drawing goes directly to the display, it waits while the
+    queue is full. With SH1106_FRAMEBUFFER ( default off, 1.2 KB
+    of RAM ) all drawing goes into a shadow buffer instead,
+    flush() sends only the changed bytes.
+    The I2C bytes are sent by the TwiQueue interrupt,
+    flush() sends as much as fits into the queue,
+    call it again until it returns true.
 
 ***************************************************/
 
 #pragma once
 
-#include <Wire.h>
 #include <Arduino.h>
+#include "TwiQueue.h"
+
+#ifndef SH1106_FRAMEBUFFER
+#define SH1106_FRAMEBUFFER 0 // 1: 1 KB shadow buffer, too big for the ATmega328 with the generator
+#endif
 
 class SimpleSH1106 {
 
     public:
+        struct Font {
+            const uint8_t *glyphs; // PROGMEM: first char, height in pages, { width, width * height bytes } ...
+            const uint16_t *index; // PROGMEM: offset of each glyph in glyphs
+            uint8_t first;         // first char
+            uint8_t count;         // number of glyphs
+            uint8_t height;        // in pages, 1 or 2
+        };
         explicit SimpleSH1106( uint8_t i2c = 0x3C );
         void init();
         void clearScreen();
+        bool flush();
         uint8_t drawImage( uint8_t col, uint8_t row, const uint8_t *bitmap );
-        uint8_t drawChar( uint8_t c, uint8_t col, uint8_t page, const uint8_t *Font );
-        uint8_t drawString( const char *s, uint8_t col, uint8_t page, const uint8_t *Font );
-        uint8_t drawString( const __FlashStringHelper *s, uint8_t col, uint8_t page, const uint8_t *Font );
-        uint8_t drawInt( long i, uint8_t col, uint8_t page, const uint8_t *Font );
+        uint8_t drawChar( uint8_t c, uint8_t col, uint8_t page, const Font &font );
+        uint8_t drawString( const char *s, uint8_t col, uint8_t page, const Font &font );
+        uint8_t drawString( const __FlashStringHelper *s, uint8_t col, uint8_t page, const Font &font );
+        uint8_t drawInt( long i, uint8_t col, uint8_t page, const Font &font );
         void drawBar( uint8_t col, uint8_t page, uint8_t bar );
+        void fillArea( uint8_t col, uint8_t page, uint8_t count, uint8_t bar ) { fillBars( col, page, count, bar ); }
         void drawBox( const char* text );
         void drawBox( const __FlashStringHelper* text );
+        void drawBox( const __FlashStringHelper* text, uint8_t part ); // one of BOX_PARTS
         bool bold = false;
-        static const uint8_t smallFont[] PROGMEM;
-        // static const uint8_t smallDigitsFont[] PROGMEM;
-        static const uint8_t largeDigitsFont[] PROGMEM;
+        uint32_t byteCount = 0; // number of bytes queued for I2C incl. address byte
+        static const Font smallFont;
+        // static const Font smallDigitsFont;
+        static const Font largeDigitsFont;
         static const uint8_t imgSmiley[] PROGMEM;
+        static const uint8_t PAGES = 8;
+        static const uint8_t COLUMNS = 128;
+        static const uint8_t BOX_PARTS = 2 * PAGES + 1;
 
     private:
         const uint8_t addrI2C;
-        const uint8_t PAGES = 8;
-        const uint8_t COLUMNS = 128;
+        static const uint8_t BURST = 31; // max data bytes per I2C transmission
         const uint8_t colOffset = 0; // = 2 for 1.3" display
+#if SH1106_FRAMEBUFFER
+        uint8_t frameBuffer[ PAGES ][ COLUMNS ]; // content of the display after flush()
+        uint8_t dirtyFirst[ PAGES ]; // changed columns per page, first > last: unchanged
+        uint8_t dirtyLast[ PAGES ];
+        uint8_t fillBits[ PAGES ][ COLUMNS / 8 ]; // bars to be filled with fillBar[ page ] by flush()
+        uint8_t fillBar[ PAGES ];
+        void applyFill( uint8_t page );
+#endif
+        uint8_t barCol;  // position of next putBar()
+        uint8_t barPage;
+        uint8_t barCount; // bars in current I2C transmission
         void setupColPage( uint8_t col, uint8_t page );
         void setupCol( uint8_t col );
         void setupPage( uint8_t page );
         void drawBar( uint8_t bar );
-        static const uint8_t imgBoxTop[] PROGMEM;
-        static const uint8_t imgBoxMid[] PROGMEM;
-        static const uint8_t imgBoxBot[] PROGMEM;
+        void startBars( uint8_t col, uint8_t page );
+        void putBar( uint8_t bar );
+        void endBars();
+        void fillBars( uint8_t col, uint8_t page, uint8_t count, uint8_t bar );
+        void drawFrame();
+        void drawFrame( uint8_t page, uint8_t half );
+        uint8_t putChar( uint8_t c, uint8_t row, const Font &font );
+        void beginI2C();
+        void writeI2C( uint8_t data );
+        void endI2C();
 };
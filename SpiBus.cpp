@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    SpiBus.cpp
+    Shared SPI transaction of the AD9833 and the MCP41010
+*/
+
+#include "SpiBus.h"
+#include "HAL.h"
+
+
+uint32_t SpiBus::transactions = 0;
+uint8_t SpiBus::_depth = 0;
+
+
+//-----------------------------------------------------------------------------
+// begin
+//   start a transaction unless one is open already
+//   the interrupts are blocked until end(), see halSpiBegin(),
+//   so _depth is changed only after beginTransaction()
+//-----------------------------------------------------------------------------
+void SpiBus::begin() {
+    if ( !_depth ) {
+        halSpiBeginTransaction();
+        ++transactions;
+    }
+    ++_depth;
+}
+
+
+void SpiBus::end() {
+    if ( !--_depth )
+        halSpiEndTransaction();
+}
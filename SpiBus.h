@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  SpiBus.h
+//    Shared SPI transaction of the AD9833 and the MCP41010
+//    both use SPI mode 3 at 10 MHz, so all writes of one tick
+//    can be grouped: the caller brackets them with begin() / end(),
+//    the begin() / end() pairs of the drivers then only nest
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+class SpiBus {
+    public:
+        static void begin();
+        static void end();
+        static uint32_t transactions; // number of SPI transactions started
+
+    private:
+        static uint8_t _depth;
+};
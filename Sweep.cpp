@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    Sweep.cpp
+    Incremental frequency sweep engine
+
+    All float math is done once in arm(), step() uses only integer add/mul.
+    The current FREQ register value is kept as 28.32 fixed point number.
+    Linear sweep: add a constant increment every step.
+    Log sweep: multiply by the constant ratio r every step, i.e. add acc * ( r - 1 ).
+    ( r - 1 ) is stored normalized as 32 bit mantissa k with at least 24 significant bits
+    and an exponent in whole bytes, to keep the accumulated error of e.g. 30000 steps
+    far below 1 LSB of the FREQ value. acc * k takes two 32 x 32 -> 64 bit multiplications,
+    the shifts are constant multiples of 8 bits, byte moves on AVR, no 64 bit library calls.
+    A triangle sweep uses a second set of values for the way back,
+    each leg restarts exactly at its start value.
+*/
+
+#include "Sweep.h"
+#include <math.h>
+
+
+Sweep::Sweep() : _fwLow( 0 ), _fwHigh( 0 ), _acc( 0 ), _log( false ), _triangle( false ), _start( false ), _leg( 0 ),
+                 _steps( 0 ), _position( 0 ) {
+    armLeg( _legs[ 0 ], 0, 0 );
+    armLeg( _legs[ 1 ], 0, 0 );
+}
+
+
+// exp( x ) - 1 without cancellation for small x ( AVR float has only 24 bit )
+static float expm1Small( float x ) {
+    uint8_t halve = 0;
+    while ( fabs( x ) > 0.01 ) {
+        x /= 2;
+        ++halve;
+    }
+    float e = x * ( 1 + x * ( 0.5 + x * ( 1.0 / 6 + x / 24 ) ) );
+    while ( halve-- )
+        e = e * ( e + 2 ); // exp( 2x ) - 1 = ( exp( x ) - 1 ) * ( exp( x ) + 1 )
+    return e;
+}
+
+
+//-----------------------------------------------------------------------------
+// arm
+//    prepare a sweep from fwFrom to fwTo in steps steps
+//    sawtooth: steps + 1 values, then restart with fwFrom
+//    triangle: steps values from fwFrom up to fwTo ( excl. ), then steps values back
+//    log sweeps need fwFrom and fwTo > 0, otherwise the sweep is linear
+//-----------------------------------------------------------------------------
+void Sweep::arm( uint32_t fwFrom, uint32_t fwTo, uint16_t steps, bool logarithmic, bool triangle ) {
+    _fwLow = fwTo < fwFrom ? fwTo : fwFrom;
+    _fwHigh = fwTo < fwFrom ? fwFrom : fwTo;
+    _steps = steps;
+    _log = logarithmic && fwFrom && fwTo;
+    _triangle = triangle && steps;
+    _leg = 0;
+    _position = 0;
+    _acc = uint64_t( fwFrom ) << 32;
+    armLeg( _legs[ 0 ], fwFrom, fwTo );
+    armLeg( _legs[ 1 ], fwTo, fwFrom );
+}
+
+
+//-----------------------------------------------------------------------------
+// armLeg
+//    precompute the increment or ratio for one direction
+//-----------------------------------------------------------------------------
+void Sweep::armLeg( Leg &leg, uint32_t fwFrom, uint32_t fwTo ) {
+    leg.fwFrom = fwFrom;
+    leg.down = fwTo < fwFrom;
+    leg.inc = 0;
+    leg.k = 0;
+    leg.bytes = 0;
+    if ( !_steps || fwFrom == fwTo )
+        return;
+    if ( _log ) {
+        float x = log( float( fwTo ) / float( fwFrom ) ) / _steps;
+        float m = expm1Small( x ); // r - 1
+        if ( leg.down )
+            m = -m; // 1 - r
+        if ( m >= 1.0 ) // ratio per step > 2, clamped, output is limited to _fwHigh
+            m = 0.99999994;
+        while ( m < 1.0 / 256 && leg.bytes < 4 ) {
+            m *= 256;
+            ++leg.bytes;
+        }
+        leg.k = uint32_t( ldexp( m, 32 ) );
+    } else {
+        leg.inc = ( int64_t( fwTo ) - int64_t( fwFrom ) ) * ( int64_t( 1 ) << 32 ) / _steps;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// step
+//    return the FREQ register value for the current position and advance
+//    restart with fwFrom after the last step, triangle: change direction
+//-----------------------------------------------------------------------------
+uint32_t Sweep::step() {
+    if ( _triangle ? _position >= _steps : _position > _steps ) {
+        if ( _triangle )
+            _leg ^= 1;
+        _position = 0;
+        _acc = uint64_t( _legs[ _leg ].fwFrom ) << 32;
+    }
+    _start = _position == 0 && _leg == 0;
+    const Leg &leg = _legs[ _leg ];
+    uint32_t fw = uint32_t( ( _acc + 0x80000000UL ) >> 32 );
+    if ( fw < _fwLow )
+        fw = _fwLow;
+    else if ( fw > _fwHigh )
+        fw = _fwHigh;
+    if ( _log ) {
+        // acc * k >> ( 32 + 8 * bytes ), the 28.32 acc in two halves
+        const uint32_t hi = uint32_t( _acc >> 32 );
+        const uint32_t lo = uint32_t( _acc );
+        uint64_t inc = uint64_t( hi ) * leg.k + ( ( uint64_t( lo ) * leg.k ) >> 32 );
+        switch ( leg.bytes ) { // constant shifts
+        case 1:
+            inc >>= 8;
+            break;
+        case 2:
+            inc >>= 16;
+            break;
+        case 3:
+            inc >>= 24;
+            break;
+        case 4:
+            inc >>= 32;
+            break;
+        }
+        if ( leg.down )
+            _acc -= inc;
+        else
+            _acc += inc;
+    } else {
+        _acc += leg.inc;
+    }
+    ++_position;
+    return fw;
+}
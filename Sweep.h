@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  Sweep.h
+//    Incremental frequency sweep engine
+//    working on AD9833 28 bit FREQ register values
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+class Sweep {
+    private:
+        struct Leg {          // one direction of the sweep, precomputed by arm()
+            uint32_t fwFrom;  // FREQ register value at position 0
+            int64_t inc;      // linear: constant 28.32 increment per step
+            uint32_t k;       // log: ( ratio - 1 ) * 2^( 32 + 8 * bytes ), normalized
+            uint8_t bytes;    // 0..4, step() shifts by whole bytes only
+            bool down;
+        };
+        Leg _legs[ 2 ];       // 0: fwFrom -> fwTo, 1: fwTo -> fwFrom ( triangle )
+        uint32_t _fwLow;      // lower and upper bound of the sweep
+        uint32_t _fwHigh;     // to catch rounding overshoot
+        uint64_t _acc;        // current FREQ value, 28.32 fixed point
+        bool _log;
+        bool _triangle;
+        bool _start;          // last step() returned the start value
+        uint8_t _leg;
+        uint16_t _steps;
+        uint16_t _position;
+        void armLeg( Leg &leg, uint32_t fwFrom, uint32_t fwTo );
+
+    public:
+        Sweep();
+        void arm( uint32_t fwFrom, uint32_t fwTo, uint16_t steps, bool logarithmic = true, bool triangle = false );
+        uint32_t step();
+        bool atStart() const { return _start; }
+        uint16_t position() const { return _position; }
+        uint16_t steps() const { return _steps; }
+};
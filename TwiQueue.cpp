@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    TwiQueue.cpp
+    Interrupt driven I2C master transmitter
+
+    The main program queues complete packets ( address + data bytes ),
+    the TWI interrupt sends them one after the other, each as
+    START, SLA+W, data, STOP. Queueing never waits ( except for a STOP
+    still on the bus, one SCL period ), a packet that does not fit
+    is dropped and counted, use space() to avoid this.
+*/
+
+#include "TwiQueue.h"
+#include "HAL.h"
+#include <util/twi.h>
+
+
+TwiQueue TwiQ;
+
+
+TwiQueue::TwiQueue() : _head( 0 ), _tail( 0 ), _write( 0 ), _packet( 0 ), _overflow( false ), _busy( false ),
+                       _remaining( 0 ) {}
+
+
+//-----------------------------------------------------------------------------
+// begin
+//   enable the TWI with SCL = F_CPU / ( 16 + 2 * twbr )
+//-----------------------------------------------------------------------------
+void TwiQueue::begin( uint8_t twbr ) {
+    halDigitalWrite( SDA, HIGH ); // internal pull-ups like Wire
+    halDigitalWrite( SCL, HIGH );
+    TWSR = 0; // prescaler 1
+    TWBR = twbr;
+    TWCR = _BV( TWEN );
+}
+
+
+//-----------------------------------------------------------------------------
+// space
+//   free bytes in the queue, a packet needs 2 bytes + data
+//-----------------------------------------------------------------------------
+uint8_t TwiQueue::space() const {
+    return ( _head - _tail - 1 ) & ( SIZE - 1 );
+}
+
+
+//-----------------------------------------------------------------------------
+// beginPacket, write, endPacket
+//   build a packet behind the queued ones, endPacket() commits it
+//   and starts the transmission if the bus is idle
+//-----------------------------------------------------------------------------
+void TwiQueue::beginPacket( uint8_t addr ) {
+    _packet = _tail;
+    _write = _tail;
+    _overflow = false;
+    write( 0 ); // length, set by endPacket()
+    write( addr );
+}
+
+
+void TwiQueue::write( uint8_t data ) {
+    uint8_t next = ( _write + 1 ) & ( SIZE - 1 );
+    if ( _overflow || next == _head ) {
+        _overflow = true;
+        return;
+    }
+    _ring[ _write ] = data;
+    _write = next;
+}
+
+
+bool TwiQueue::endPacket() {
+    if ( _overflow ) {
+        ++drops;
+        return false;
+    }
+    _ring[ _packet ] = ( _write - _packet - 2 ) & ( SIZE - 1 );
+    _tail = _write; // commit, must be done before checking _busy
+    ++packets;
+    uint8_t used = ( _tail - _head ) & ( SIZE - 1 );
+    if ( used > highWater )
+        highWater = used;
+    if ( !_busy ) {
+        _busy = true;
+        while ( TWCR & _BV( TWSTO ) ) // STOP of the last packet not yet on the bus
+            ;
+        TWCR = _BV( TWINT ) | _BV( TWSTA ) | _BV( TWEN ) | _BV( TWIE ); // START
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// handleInterrupt
+//   TWI state machine, called from the TWI interrupt
+//-----------------------------------------------------------------------------
+void TwiQueue::handleInterrupt() {
+    const uint8_t next = _BV( TWINT ) | _BV( TWEN ) | _BV( TWIE );
+    switch ( TW_STATUS ) {
+    case TW_START:
+    case TW_REP_START: // send address of the next packet
+        _remaining = _ring[ _head ];
+        TWDR = ( _ring[ ( _head + 1 ) & ( SIZE - 1 ) ] << 1 ) | TW_WRITE;
+        _head = ( _head + 2 ) & ( SIZE - 1 );
+        TWCR = next;
+        return;
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK: // send next data byte
+        if ( _remaining ) {
+            TWDR = _ring[ _head ];
+            _head = ( _head + 1 ) & ( SIZE - 1 );
+            --_remaining;
+            TWCR = next;
+            return;
+        }
+        break;
+    default: // NACK, bus error: skip the rest of this packet
+        ++errors;
+        _head = ( _head + _remaining ) & ( SIZE - 1 );
+        _remaining = 0;
+        break;
+    }
+    // packet complete
+    if ( _head != _tail ) {
+        TWCR = next | _BV( TWSTO ) | _BV( TWSTA ); // STOP, then START of next packet
+    } else {
+        TWCR = _BV( TWINT ) | _BV( TWEN ) | _BV( TWSTO ); // STOP, idle
+        _busy = false;
+    }
+}
+
+
+ISR( TWI_vect ) {
+    TwiQ.handleInterrupt();
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  TwiQueue.h
+//    Interrupt driven I2C master transmitter
+//    packets are queued in a ring buffer and sent from the TWI interrupt
+//    replaces Wire ( both use the TWI interrupt )
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+class TwiQueue {
+    private:
+        static const uint8_t SIZE = 128; // ring buffer size, power of 2
+        uint8_t _ring[ SIZE ];           // packets: length, address, data bytes
+        volatile uint8_t _head;          // next byte to send, changed by ISR
+        volatile uint8_t _tail;          // end of committed packets
+        uint8_t _write;                  // write position of the packet in progress
+        uint8_t _packet;                 // start of the packet in progress
+        bool _overflow;                  // packet in progress did not fit
+        volatile bool _busy;             // ISR is sending
+        volatile uint8_t _remaining;     // data bytes left in the current packet
+
+    public:
+        TwiQueue();
+        void begin( uint8_t twbr );
+        void beginPacket( uint8_t addr );
+        void write( uint8_t data );
+        bool endPacket();
+        uint8_t space() const;
+        bool busy() const { return _busy; }
+        uint32_t sclFrequency() const { return F_CPU / ( 16 + 2 * TWBR ); }
+        void handleInterrupt();
+        uint8_t highWater = 0; // max. number of queued bytes
+        uint16_t drops = 0;    // packets that did not fit into the queue
+        uint16_t errors = 0;   // packets not acknowledged
+        uint32_t packets = 0;  // packets queued
+};
+
+extern TwiQueue TwiQ;
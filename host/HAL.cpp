@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    HAL.cpp
+    Hardware abstraction of the host build, see Mock.h
+
+    Timer: tick and symbol clock at exact times, timer counts of 4 µs
+    SPI: F_CPU / 2 = 8 MHz, the chip select is the pin last driven low
+    Serial: 64 byte buffers, the bytes take 10 bits at the baud rate,
+            a write to a full buffer waits like the Arduino core
+    Pins: inputs with pull-up, mockSetPin() drives them
+*/
+
+#include "HAL.h"
+#include "Mock.h"
+
+
+static const uint32_t countNs = 64000000000ULL / F_CPU; // timer1 count, prescaler 64
+static uint64_t tickNs = 0;
+static uint64_t tickStart = 0;
+static uint64_t tickIndex = 0;
+
+static uint32_t symbolMilli = 0; // rate in mHz
+static uint64_t symbolStart = 0;
+static uint32_t symbolIndex = 0;
+
+
+//-----------------------------------------------------------------------------
+// tick
+//-----------------------------------------------------------------------------
+static void tickStep() {
+    mockRaise( miTick );
+    mockSchedule( msTick, tickStart + ++tickIndex * tickNs );
+}
+
+
+void halInitTick( uint16_t rate, void ( *handler )() ) {
+    tickNs = 1000000000ULL / rate;
+    tickStart = mockNanos();
+    tickIndex = 1;
+    mockAttach( miTick, handler );
+    mockSchedule( msTick, tickStart + tickNs, tickStep );
+}
+
+
+uint16_t halTickPhase() { return ( mockNanos() - tickStart ) % tickNs / countNs; }
+
+
+uint16_t halTickPeriod() { return tickNs / countNs; }
+
+
+uint16_t halTickMicros( uint16_t counts ) { return uint32_t( counts ) * countNs / 1000; }
+
+
+unsigned long halMicros() { return ( mockNanos() - tickStart ) / countNs * countNs / 1000; }
+
+
+//-----------------------------------------------------------------------------
+// symbol clock, symbol n at start + n / rate
+//-----------------------------------------------------------------------------
+static void symbolStep() {
+    mockRaise( miSymbol );
+    ++symbolIndex;
+    mockSchedule( msSymbol, symbolStart + symbolIndex * 1000000000000ULL / symbolMilli );
+}
+
+
+void halStartSymbols( uint16_t rate, void ( *handler )(), uint16_t milliHz ) {
+    const bool was = mockBlock();
+    symbolMilli = uint32_t( rate ) * 1000 + milliHz;
+    symbolStart = mockNanos() + 8 * countNs; // first symbol after 32 µs
+    symbolIndex = 0;
+    mockAttach( miSymbol, handler );
+    mockSchedule( msSymbol, symbolStart, symbolStep );
+    mockRestore( was );
+}
+
+
+void halStopSymbols() {
+    mockSchedule( msSymbol, mockNever );
+    mockAttach( miSymbol, 0 );
+}
+
+
+//-----------------------------------------------------------------------------
+// digital pins
+//-----------------------------------------------------------------------------
+static const uint8_t PINS = 20;
+static const uint8_t extPin = 2;
+static uint8_t pinLevel[ PINS ] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }; // pulled up
+static uint8_t spiSelect = 0; // chip select of the SPI transfers
+
+
+void halPinMode( uint8_t pin, uint8_t mode ) {}
+
+
+void halDigitalWrite( uint8_t pin, uint8_t level ) {
+    if ( pin >= PINS || pinLevel[ pin ] == level )
+        return;
+    pinLevel[ pin ] = level;
+    mockRecord( mbPin, mockNanos(), 0, pin, 0, level );
+    if ( !level )
+        spiSelect = pin;
+}
+
+
+int halDigitalRead( uint8_t pin ) { return pin < PINS ? pinLevel[ pin ] : LOW; }
+
+
+void mockSetPin( uint8_t pin, bool level ) {
+    if ( pin >= PINS || pinLevel[ pin ] == level )
+        return;
+    pinLevel[ pin ] = level;
+    if ( pin == extPin )
+        mockRaise( miPinChange ); // if enabled
+    const bool was = mockBlock();
+    mockRestore( was ); // run it now if the interrupts are enabled
+}
+
+
+bool mockPin( uint8_t pin ) { return pin < PINS && pinLevel[ pin ]; }
+
+
+void halStartPinChange( void ( *handler )() ) { mockAttach( miPinChange, handler ); }
+
+
+void halStopPinChange() { mockAttach( miPinChange, 0 ); }
+
+
+bool halExtInput() { return pinLevel[ extPin ]; }
+
+
+void halInitChargePump( uint8_t pin ) {}
+
+
+//-----------------------------------------------------------------------------
+// SPI
+//   a transaction blocks the interrupts like SPI.usingInterrupt( 255 )
+//-----------------------------------------------------------------------------
+static const uint32_t spiBitNs = 2000000000ULL / F_CPU;
+static bool spiInterrupts = false;
+
+
+void halSpiBegin() {}
+
+
+void halSpiBeginTransaction() { spiInterrupts = mockBlock(); }
+
+
+void halSpiEndTransaction() { mockRestore( spiInterrupts ); }
+
+
+uint8_t halSpiTransfer( uint8_t data ) {
+    mockRecord( mbSpi, mockNanos(), 8 * spiBitNs, spiSelect, 8, data );
+    mockAdvance( 8 * spiBitNs );
+    return 0;
+}
+
+
+uint16_t halSpiTransfer16( uint16_t data ) {
+    mockRecord( mbSpi, mockNanos(), 16 * spiBitNs, spiSelect, 16, data );
+    mockAdvance( 16 * spiBitNs );
+    return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// serial port
+//-----------------------------------------------------------------------------
+class MockSerial : public Stream {
+    public:
+        static const uint8_t SIZE = 64; // buffers of the Arduino core, one byte stays free
+        uint32_t byteNs = 86806;       // 10 bits at 115200 baud
+        std::string output;
+        std::string arriving;          // not yet received
+        std::string rx;
+        std::string tx;                // waiting for the transmitter
+        uint32_t overruns = 0;         // received bytes lost, buffer full
+
+        int available() override { return rx.size(); }
+        int read() override {
+            if ( rx.empty() )
+                return -1;
+            const uint8_t c = rx[ 0 ];
+            rx.erase( 0, 1 );
+            return c;
+        }
+        int peek() override { return rx.empty() ? -1 : uint8_t( rx[ 0 ] ); }
+        int availableForWrite() override { return SIZE - 1 - tx.size(); }
+        size_t write( uint8_t c ) override;
+        using Print::write;
+};
+
+static MockSerial serial;
+Stream &halSerial = serial;
+
+
+// the transmitter finished a byte, start the next one
+static void txStep() {
+    if ( serial.tx.empty() )
+        return;
+    const uint8_t c = serial.tx[ 0 ];
+    serial.tx.erase( 0, 1 );
+    mockRecord( mbSerialTx, mockNanos(), serial.byteNs, 0, 1, c );
+    serial.output += char( c );
+    mockSchedule( msTx, mockNanos() + serial.byteNs, txStep );
+}
+
+
+size_t MockSerial::write( uint8_t c ) {
+    while ( tx.size() >= SIZE - 1 )
+        mockAdvance( mockDue( msTx ) - mockNanos() );
+    tx += char( c );
+    if ( mockDue( msTx ) == mockNever )
+        txStep();
+    return 1;
+}
+
+
+// a byte arrived
+static void rxStep() {
+    const uint8_t c = serial.arriving[ 0 ];
+    serial.arriving.erase( 0, 1 );
+    mockRecord( mbSerialRx, mockNanos() - serial.byteNs, serial.byteNs, 0, 1, c );
+    if ( serial.rx.size() < MockSerial::SIZE - 1 )
+        serial.rx += char( c );
+    else
+        ++serial.overruns;
+    if ( !serial.arriving.empty() )
+        mockSchedule( msRx, mockNanos() + serial.byteNs, rxStep );
+}
+
+
+void halSerialBegin( unsigned long baud ) { serial.byteNs = 10000000000ULL / baud; }
+
+
+void mockSerialInput( const std::string &text ) {
+    if ( text.empty() )
+        return;
+    if ( serial.arriving.empty() )
+        mockSchedule( msRx, mockNanos() + serial.byteNs, rxStep );
+    serial.arriving += text;
+}
+
+
+std::string mockSerialOutput() {
+    std::string s;
+    s.swap( serial.output );
+    return s;
+}
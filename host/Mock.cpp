@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    Mock.cpp
+    Clock, interrupts and transaction log of the host build,
+    time and interrupt functions of the Arduino core and the EEPROM
+
+    The clock counts ns. mockAdvance() moves it to the next due peripheral
+    ( tick, symbol clock, I2C, serial ), calls its step function and
+    runs the raised interrupts when they are enabled. An interrupt handler
+    runs with the interrupts disabled, if it waits for a bus the clock
+    advances and the interrupts raised meanwhile stay pending.
+*/
+
+#include "Mock.h"
+#include <EEPROM.h>
+
+
+void loop(); // of the sketch
+
+std::vector< mockEvent_t > mockLog;
+
+static uint64_t now = 0;
+static bool enabled = false; // global interrupt flag, cleared like after reset until sei()
+
+static void ( *handlers[ MOCKIRQS ] )() = {};
+static bool pending[ MOCKIRQS ] = {};
+static uint32_t irqCount[ MOCKIRQS ] = {};
+
+static uint64_t due[ MOCKSOURCES ] = { mockNever, mockNever, mockNever, mockNever, mockNever };
+static void ( *steps[ MOCKSOURCES ] )() = {};
+
+
+uint64_t mockNanos() { return now; }
+
+
+//-----------------------------------------------------------------------------
+// interrupts
+//-----------------------------------------------------------------------------
+void mockAttach( mockIrq_t irq, void ( *handler )() ) {
+    handlers[ irq ] = handler;
+    pending[ irq ] = false;
+}
+
+
+void mockRaise( mockIrq_t irq ) {
+    if ( handlers[ irq ] )
+        pending[ irq ] = true;
+}
+
+
+uint32_t mockIrqCount( mockIrq_t irq ) { return irqCount[ irq ]; }
+
+
+// run the pending interrupts, lowest vector first, like the AVR
+static void deliver() {
+    while ( enabled ) {
+        uint8_t irq = 0;
+        while ( irq < MOCKIRQS && !pending[ irq ] )
+            ++irq;
+        if ( irq == MOCKIRQS )
+            return;
+        pending[ irq ] = false;
+        ++irqCount[ irq ];
+        enabled = false;
+        handlers[ irq ]();
+        enabled = true;
+    }
+}
+
+
+bool mockBlock() {
+    const bool was = enabled;
+    enabled = false;
+    return was;
+}
+
+
+void mockRestore( bool was ) {
+    enabled = was;
+    deliver();
+}
+
+
+void noInterrupts() { enabled = false; }
+
+
+void interrupts() {
+    enabled = true;
+    deliver();
+}
+
+
+//-----------------------------------------------------------------------------
+// clock
+//-----------------------------------------------------------------------------
+void mockSchedule( mockSource_t source, uint64_t at, void ( *step )() ) {
+    due[ source ] = at;
+    if ( step )
+        steps[ source ] = step;
+}
+
+
+uint64_t mockDue( mockSource_t source ) { return due[ source ]; }
+
+
+//-----------------------------------------------------------------------------
+// mockAdvance
+//   handle the peripherals in the order they are due, a nested call
+//   from an interrupt handler may have moved the clock further already
+//-----------------------------------------------------------------------------
+void mockAdvance( uint64_t ns ) {
+    const uint64_t end = now + ns;
+    for ( ;; ) {
+        uint8_t next = MOCKSOURCES;
+        for ( uint8_t s = 0; s < MOCKSOURCES; ++s )
+            if ( due[ s ] <= end && ( next == MOCKSOURCES || due[ s ] < due[ next ] ) )
+                next = s;
+        if ( next == MOCKSOURCES )
+            break;
+        if ( due[ next ] > now )
+            now = due[ next ];
+        due[ next ] = mockNever; // the step schedules the next one
+        steps[ next ]();
+        deliver();
+    }
+    if ( end > now )
+        now = end;
+    deliver();
+}
+
+
+//-----------------------------------------------------------------------------
+// mockRun
+//   the main loop of the board: loop() waits for the next tick in
+//   Scheduler::run(), here the clock jumps to it
+//-----------------------------------------------------------------------------
+void mockRun( uint32_t us ) {
+    static uint32_t ticksRun = 0;
+    const uint64_t end = now + uint64_t( us ) * 1000;
+    while ( now < end ) {
+        if ( irqCount[ miTick ] != ticksRun ) {
+            ticksRun = irqCount[ miTick ];
+            loop();
+        } else {
+            const uint64_t next = due[ msTick ] < end ? due[ msTick ] : end;
+            mockAdvance( next > now ? next - now : 0 );
+        }
+    }
+}
+
+
+unsigned long millis() { return now / 1000000; }
+
+
+unsigned long micros() { return now / 1000; }
+
+
+void delay( unsigned long ms ) { mockAdvance( uint64_t( ms ) * 1000000 ); }
+
+
+void delayMicroseconds( unsigned int us ) { mockAdvance( uint64_t( us ) * 1000 ); }
+
+
+//-----------------------------------------------------------------------------
+// transaction log
+//-----------------------------------------------------------------------------
+void mockRecord( mockBus_t bus, uint64_t ns, uint32_t duration, uint8_t device, uint16_t size, uint32_t data ) {
+    mockLog.push_back( { ns, duration, bus, device, size, data } );
+}
+
+
+void mockPrintLog( FILE *out, size_t first ) {
+    static const char *const names[] = { "spi", "i2c", "tx", "rx", "pin", "eeprom" };
+    for ( size_t i = first; i < mockLog.size(); ++i ) {
+        const mockEvent_t &e = mockLog[ i ];
+        fprintf( out, "%llu.%03u,%s,%u,%u,0x%X\n", (unsigned long long)( e.ns / 1000 ), unsigned( e.ns % 1000 ),
+                 names[ e.bus ], e.device, e.size, unsigned( e.data ) );
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// EEPROM
+//   erased at start, a write blocks until the previous one is done
+//-----------------------------------------------------------------------------
+EEPROMClass EEPROM;
+
+static const uint32_t eepromWriteNs = 3400000;
+static uint8_t eepromCells[ E2END + 1 ];
+static uint64_t eepromReady = 0;
+static struct EepromErase {
+    EepromErase() { memset( eepromCells, 0xFF, sizeof( eepromCells ) ); }
+} eepromErase;
+
+
+bool eeprom_is_ready() { return now >= eepromReady; }
+
+
+uint8_t EEPROMClass::read( int idx ) { return eepromCells[ idx & E2END ]; }
+
+
+void EEPROMClass::write( int idx, uint8_t val ) {
+    if ( now < eepromReady )
+        mockAdvance( eepromReady - now );
+    eepromCells[ idx & E2END ] = val;
+    mockRecord( mbEeprom, now, eepromWriteNs, 0, idx & E2END, val );
+    eepromReady = now + eepromWriteNs;
+}
+
+
+void EEPROMClass::update( int idx, uint8_t val ) {
+    if ( read( idx ) != val )
+        write( idx, val );
+}
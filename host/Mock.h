@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  Mock.h
+//    Mock backends of the host build: clock, interrupts, SPI, I2C,
+//    serial port, digital pins and EEPROM
+//    every bus transaction is recorded with its time in mockLog
+//
+//    the firmware code runs in zero time, the clock advances only
+//    while it waits for a bus ( SPI transfer, full serial buffer,
+//    EEPROM write ) and when a busy wait polls the I2C queue ( 1 µs ),
+//    so task durations are bus times and deterministic
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+enum mockBus_t : uint8_t { mbSpi, mbI2c, mbSerialTx, mbSerialRx, mbPin, mbEeprom };
+
+struct mockEvent_t {
+    uint64_t ns;       // start of the transaction
+    uint32_t duration; // ns on the bus
+    mockBus_t bus;
+    uint8_t device;    // SPI: chip select pin, I2C: address, pin: number, EEPROM: 0
+    uint16_t size;     // SPI: bits, I2C: data bytes, serial: 1, pin: 0, EEPROM: address
+    uint32_t data;     // SPI: word, I2C: first data byte, serial: char, pin: level, EEPROM: value
+};
+
+extern std::vector< mockEvent_t > mockLog;
+
+// clock
+uint64_t mockNanos();
+void mockAdvance( uint64_t ns ); // let time pass, deliver the due interrupts
+void mockRun( uint32_t us );     // call loop() for every tick during us, like the board after setup()
+
+// serial input arrives at the baud rate, output is collected
+void mockSerialInput( const std::string &text );
+std::string mockSerialOutput(); // bytes sent since the last call
+
+// digital pins driven from outside, e.g. buttons or the external input
+void mockSetPin( uint8_t pin, bool level );
+bool mockPin( uint8_t pin ); // level of an output
+
+// SH1106 RAM written over I2C: page, column
+extern uint8_t mockDisplay[ 8 ][ 132 ];
+
+// print the log from event first on, one line per event: time µs, bus, device, size, data
+void mockPrintLog( FILE *out, size_t first = 0 );
+
+
+// backend of host/HAL.cpp and host/TwiQueue.cpp
+
+// interrupts in the order of the AVR vector table, a raised one runs
+// when the interrupts are enabled, one pending flag per interrupt
+enum mockIrq_t : uint8_t { miPinChange, miTick, miSymbol, MOCKIRQS };
+void mockAttach( mockIrq_t irq, void ( *handler )() ); // 0: disabled
+void mockRaise( mockIrq_t irq );
+uint32_t mockIrqCount( mockIrq_t irq ); // handler calls
+bool mockBlock();                  // disable the interrupts, return the previous state
+void mockRestore( bool enabled );  // and run the pending ones
+
+// peripherals that act at a given time
+enum mockSource_t : uint8_t { msTick, msSymbol, msTwi, msTx, msRx, MOCKSOURCES };
+const uint64_t mockNever = UINT64_MAX;
+void mockSchedule( mockSource_t source, uint64_t due, void ( *step )() = 0 ); // step is called at due
+uint64_t mockDue( mockSource_t source );
+
+void mockRecord( mockBus_t bus, uint64_t ns, uint32_t duration, uint8_t device, uint16_t size, uint32_t data );
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    TwiQueue.cpp
+    I2C queue of the host build, see Mock.h
+
+    Same queue as on the board, the bus sends the packets at the SCL
+    frequency of TWBR: START and STOP one bit, address and data bytes
+    9 bits each. Every packet is recorded when its STOP is sent,
+    the SH1106 commands and data are decoded into mockDisplay.
+    Polling space() costs 1 µs, so busy waits let the bus progress.
+*/
+
+#include "TwiQueue.h"
+#include "Mock.h"
+
+
+TwiQueue TwiQ;
+uint8_t TWBR = 0;
+uint8_t mockDisplay[ 8 ][ 132 ];
+
+static uint64_t packetStart = 0;
+static uint8_t packetAddress = 0;
+static bool addressSent = false;
+static uint64_t busFree = 0; // end of the last STOP
+static std::vector< uint8_t > packetData;
+static uint8_t displayPage = 0;
+static uint8_t displayColumn = 0;
+
+
+TwiQueue::TwiQueue() : _head( 0 ), _tail( 0 ), _write( 0 ), _packet( 0 ), _overflow( false ), _busy( false ),
+                       _remaining( 0 ) {}
+
+
+void TwiQueue::begin( uint8_t twbr ) { TWBR = twbr; }
+
+
+uint8_t TwiQueue::space() const {
+    mockAdvance( 1000 );
+    return ( _head - _tail - 1 ) & ( SIZE - 1 );
+}
+
+
+void TwiQueue::beginPacket( uint8_t addr ) {
+    _packet = _tail;
+    _write = _tail;
+    _overflow = false;
+    write( 0 ); // length, set by endPacket()
+    write( addr );
+}
+
+
+void TwiQueue::write( uint8_t data ) {
+    uint8_t next = ( _write + 1 ) & ( SIZE - 1 );
+    if ( _overflow || next == _head ) {
+        _overflow = true;
+        return;
+    }
+    _ring[ _write ] = data;
+    _write = next;
+}
+
+
+static uint64_t bitNs() { return 1000000000ULL / TwiQ.sclFrequency(); }
+
+
+static void busStep() { TwiQ.handleInterrupt(); }
+
+
+bool TwiQueue::endPacket() {
+    if ( _overflow ) {
+        ++drops;
+        return false;
+    }
+    _ring[ _packet ] = ( _write - _packet - 2 ) & ( SIZE - 1 );
+    _tail = _write;
+    ++packets;
+    uint8_t used = ( _tail - _head ) & ( SIZE - 1 );
+    if ( used > highWater )
+        highWater = used;
+    if ( !_busy ) {
+        _busy = true;
+        const uint64_t start = busFree > mockNanos() ? busFree : mockNanos();
+        mockSchedule( msTwi, start + bitNs(), busStep ); // START
+    }
+    return true;
+}
+
+
+// SH1106: control byte 0x00 commands, 0x40 display data
+static void decodePacket() {
+    if ( packetData.empty() )
+        return;
+    if ( packetData[ 0 ] == 0x00 ) {
+        for ( size_t i = 1; i < packetData.size(); ++i ) {
+            const uint8_t c = packetData[ i ];
+            if ( ( c & 0xF0 ) == 0xB0 )
+                displayPage = c & 7;
+            else if ( ( c & 0xF0 ) == 0x00 )
+                displayColumn = ( displayColumn & 0xF0 ) | ( c & 0x0F );
+            else if ( ( c & 0xF0 ) == 0x10 )
+                displayColumn = ( displayColumn & 0x0F ) | ( c & 0x0F ) << 4;
+        }
+    } else if ( packetData[ 0 ] == 0x40 ) {
+        for ( size_t i = 1; i < packetData.size(); ++i )
+            if ( displayColumn < 132 )
+                mockDisplay[ displayPage ][ displayColumn++ ] = packetData[ i ];
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// handleInterrupt
+//   the bus finished the START ( or the previous byte ), send the next byte
+//   or the STOP, a new packet starts right after it
+//-----------------------------------------------------------------------------
+void TwiQueue::handleInterrupt() {
+    const uint64_t bit = bitNs();
+    if ( !addressSent ) { // START done, send the address
+        addressSent = true;
+        packetStart = mockNanos() - bit;
+        _remaining = _ring[ _head ];
+        packetAddress = _ring[ ( _head + 1 ) & ( SIZE - 1 ) ];
+        _head = ( _head + 2 ) & ( SIZE - 1 );
+        mockSchedule( msTwi, mockNanos() + 9 * bit );
+        return;
+    }
+    if ( _remaining ) { // address or data byte done, send the next data byte
+        packetData.push_back( _ring[ _head ] );
+        _head = ( _head + 1 ) & ( SIZE - 1 );
+        --_remaining;
+        mockSchedule( msTwi, mockNanos() + 9 * bit );
+        return;
+    }
+    // STOP
+    const uint64_t end = mockNanos() + bit;
+    mockRecord( mbI2c, packetStart, end - packetStart, packetAddress, packetData.size(),
+                packetData.empty() ? 0 : packetData[ 0 ] );
+    decodePacket();
+    packetData.clear();
+    addressSent = false;
+    busFree = end;
+    if ( _head != _tail ) {
+        mockSchedule( msTwi, end + bit ); // START of the next packet
+    } else {
+        _busy = false;
+        mockSchedule( msTwi, mockNever );
+    }
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    Arduino.cpp
+    Print of the minimal Arduino core for the host build,
+    same number formats as the AVR core
+    the time and interrupt functions are in Mock.cpp
+*/
+
+#include <Arduino.h>
+
+
+size_t Print::write( const uint8_t *buffer, size_t size ) {
+    size_t n = 0;
+    while ( size-- ) {
+        if ( !write( *buffer++ ) )
+            break;
+        ++n;
+    }
+    return n;
+}
+
+
+size_t Print::print( const __FlashStringHelper *s ) { return write( reinterpret_cast< const char * >( s ) ); }
+
+
+size_t Print::print( long n, int base ) {
+    if ( base == DEC && n < 0 )
+        return print( '-' ) + printNumber( -(unsigned long)n, DEC );
+    return printNumber( n, base );
+}
+
+
+size_t Print::print( unsigned long n, int base ) { return printNumber( n, base ); }
+
+
+size_t Print::printNumber( unsigned long n, uint8_t base ) {
+    char buf[ 8 * sizeof( long ) + 1 ];
+    char *s = &buf[ sizeof( buf ) - 1 ];
+    *s = 0;
+    if ( base < 2 )
+        base = 10;
+    do {
+        const char c = n % base;
+        n /= base;
+        *--s = c < 10 ? c + '0' : c + 'A' - 10;
+    } while ( n );
+    return write( s );
+}
+
+
+size_t Print::print( double number, int digits ) {
+    if ( isnan( number ) )
+        return print( "nan" );
+    if ( isinf( number ) )
+        return print( "inf" );
+    size_t n = 0;
+    if ( number < 0.0 ) {
+        n += print( '-' );
+        number = -number;
+    }
+    double rounding = 0.5;
+    for ( int i = 0; i < digits; ++i )
+        rounding /= 10.0;
+    number += rounding;
+    unsigned long whole = (unsigned long)number;
+    double remainder = number - (double)whole;
+    n += print( whole );
+    if ( digits > 0 )
+        n += print( '.' );
+    while ( digits-- > 0 ) {
+        remainder *= 10.0;
+        const unsigned int digit = unsigned( remainder );
+        n += print( digit );
+        remainder -= digit;
+    }
+    return n;
+}
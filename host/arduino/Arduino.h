@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  Arduino.h
+//    Minimal Arduino core for the host build
+//    types, Print / Stream, PROGMEM and the time and interrupt functions,
+//    no SPI, Serial or pin functions: the firmware uses HAL.h for them
+//    note: int is 32 bit on the host
+//
+//******************************************
+
+#pragma once
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define lowByte( w ) ( (uint8_t)( ( w ) & 0xff ) )
+#define highByte( w ) ( (uint8_t)( ( w ) >> 8 ) )
+#define bitRead( value, bit ) ( ( ( value ) >> ( bit ) ) & 0x01 )
+#define bitSet( value, bit ) ( ( value ) |= ( 1UL << ( bit ) ) )
+#define bitClear( value, bit ) ( ( value ) &= ~( 1UL << ( bit ) ) )
+#define bit( b ) ( 1UL << ( b ) )
+#define constrain( amt, low, high ) ( ( amt ) < ( low ) ? ( low ) : ( ( amt ) > ( high ) ? ( high ) : ( amt ) ) )
+
+class __FlashStringHelper;
+#define F( string_literal ) ( reinterpret_cast< const __FlashStringHelper * >( PSTR( string_literal ) ) )
+
+unsigned long millis();
+unsigned long micros();
+void delay( unsigned long ms );
+void delayMicroseconds( unsigned int us );
+void noInterrupts();
+void interrupts();
+
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write( uint8_t ) = 0;
+        size_t write( const char *str ) { return str ? write( (const uint8_t *)str, strlen( str ) ) : 0; }
+        virtual size_t write( const uint8_t *buffer, size_t size );
+        size_t write( const char *buffer, size_t size ) { return write( (const uint8_t *)buffer, size ); }
+        virtual int availableForWrite() { return 0; }
+        virtual void flush() {}
+
+        size_t print( const __FlashStringHelper *s );
+        size_t print( const char s[] ) { return write( s ); }
+        size_t print( char c ) { return write( uint8_t( c ) ); }
+        size_t print( unsigned char n, int base = DEC ) { return print( (unsigned long)n, base ); }
+        size_t print( int n, int base = DEC ) { return print( (long)n, base ); }
+        size_t print( unsigned int n, int base = DEC ) { return print( (unsigned long)n, base ); }
+        size_t print( long n, int base = DEC );
+        size_t print( unsigned long n, int base = DEC );
+        size_t print( double n, int digits = 2 );
+
+        size_t println() { return write( "\r\n" ); }
+        template < typename T > size_t println( T value ) { return print( value ) + println(); }
+        template < typename T > size_t println( T value, int format ) { return print( value, format ) + println(); }
+
+    private:
+        size_t printNumber( unsigned long n, uint8_t base );
+};
+
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+};
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  EEPROM.h
+//    EEPROM of the host build, 1 KB, a write takes 3.4 ms
+//    like the ATmega328, see Mock.cpp
+//
+//******************************************
+
+#pragma once
+
+#include <Arduino.h>
+
+bool eeprom_is_ready();
+
+struct EEPROMClass {
+    uint8_t read( int idx );
+    void write( int idx, uint8_t val ); // waits until a running write is done
+    void update( int idx, uint8_t val );
+    uint16_t length() { return E2END + 1; }
+};
+
+extern EEPROMClass EEPROM;
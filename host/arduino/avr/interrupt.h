@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  avr/interrupt.h
+//    global interrupt flag of the mock clock, see Mock.cpp
+//
+//******************************************
+
+#pragma once
+
+void noInterrupts();
+void interrupts();
+
+#define sei() interrupts()
+#define cli() noInterrupts()
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  avr/io.h
+//    the few ATmega328 definitions the firmware uses outside of
+//    HAL.cpp and TwiQueue.cpp
+//
+//******************************************
+
+#pragma once
+
+#include <stdint.h>
+
+#define _BV( bit ) ( 1 << ( bit ) )
+
+#define E2END 0x3FF // last EEPROM address
+
+extern uint8_t TWBR; // TWI bit rate, see TwiQueue::sclFrequency()
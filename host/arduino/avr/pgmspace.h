@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  avr/pgmspace.h
+//    PROGMEM is ordinary memory on the host
+//
+//******************************************
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR( s ) ( s )
+
+#define pgm_read_byte( addr ) ( *(const uint8_t *)( addr ) )
+#define pgm_read_word( addr ) ( *(const uint16_t *)( addr ) )
+#define pgm_read_dword( addr ) ( *(const uint32_t *)( addr ) )
+#define pgm_read_ptr( addr ) ( *(void *const *)( addr ) )
+#define pgm_read_byte_near( addr ) pgm_read_byte( addr )
+#define pgm_read_word_near( addr ) pgm_read_word( addr )
+
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strcpy_P strcpy
+#define strlen_P strlen
@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    bench.cpp
+    Benchmark of the host build: replays fixed scenarios against the
+    firmware and measures the bus traffic in the transaction log of Mock.h
+      keys:   idle redraw, cursor move, digit change
+      sweep:  one period of a 30 s log sweep 1 kHz .. 20 kHz, tick by tick
+      serial: scripted commands, latency from the command to the bus
+    The bus times are the recorded transaction times at the configured
+    TWI and SPI clocks, overruns and missed ticks come from the scheduler,
+    the tasks are found by their names. The mock clock advances only while
+    the firmware waits for a bus, not for computation, so task run times
+    are not measured here, see the L command on the target.
+
+    One CSV line per metric, the last line sums up the failed limits:
+      bench,<case>,<metric>,<value>,<limit>,<ok|FAIL>
+      bench,result,fails,<n>,0,<PASS|FAIL>
+    exit code 1 if a limit is exceeded
+*/
+
+#include "Button.h"
+#include "Mock.h"
+#include "Scheduler.h"
+#include "SimpleSH1106.h"
+
+void setup();
+extern Scheduler SCH;
+
+// pins of the sketch
+static const uint8_t btnUp = 5;
+static const uint8_t btnDown = 6;
+static const uint8_t btnRight = 7;
+static const uint8_t testOut = 4; // sweep sync
+static const uint8_t adSelect = 10; // AD9833 FSYNC
+static const uint8_t potSelect = 9; // MCP41010 CS
+static const uint8_t numDigits = 7; // frequency digits of the menu
+
+static const uint32_t noLimit = UINT32_MAX;
+static uint8_t fails = 0;
+
+
+// print a CSV result line, count it if the limit is exceeded
+static void result( const char *name, const char *metric, uint32_t value, uint32_t limit = noLimit ) {
+    const bool fail = value > limit;
+    printf( "bench,%s,%s,%lu,", name, metric, (unsigned long)value );
+    if ( limit != noLimit )
+        printf( "%lu", (unsigned long)limit );
+    printf( fail ? ",FAIL\n" : ",ok\n" );
+    fails += fail;
+}
+
+
+//-----------------------------------------------------------------------------
+// scheduler
+//-----------------------------------------------------------------------------
+static const Scheduler::Task &task( const char *name ) {
+    for ( uint8_t i = 0; i < SCH.count(); ++i )
+        if ( !strcmp_P( name, SCH.task( i ).name ) )
+            return SCH.task( i );
+    fprintf( stderr, "no task %s\n", name );
+    exit( 2 );
+}
+
+
+// overruns of all tasks and ticks without a run since the last clearStats()
+static uint32_t overruns() {
+    uint32_t n = SCH.missed;
+    for ( uint8_t i = 0; i < SCH.count(); ++i )
+        n += SCH.task( i ).overruns;
+    return n;
+}
+
+
+//-----------------------------------------------------------------------------
+// bus traffic of the log events first..last
+//   I2C bytes include the address byte
+//-----------------------------------------------------------------------------
+struct traffic_t {
+    uint32_t i2cBytes;
+    uint32_t i2cPackets;
+    uint64_t i2cNs;
+    uint32_t spiWords; // 16 bit
+    uint64_t spiNs;
+};
+
+
+static traffic_t traffic( size_t first, size_t last = mockLog.size() ) {
+    traffic_t t = {};
+    for ( size_t i = first; i < last; ++i ) {
+        const mockEvent_t &e = mockLog[ i ];
+        if ( e.bus == mbI2c ) {
+            t.i2cBytes += e.size + 1;
+            ++t.i2cPackets;
+            t.i2cNs += e.duration;
+        } else if ( e.bus == mbSpi ) {
+            t.spiWords += e.size;
+            t.spiNs += e.duration;
+        }
+    }
+    t.spiWords /= 16;
+    return t;
+}
+
+
+// start of the first event of bus and device from first on, mockNever if none
+static uint64_t firstEvent( size_t first, mockBus_t bus, int device = -1 ) {
+    for ( size_t i = first; i < mockLog.size(); ++i )
+        if ( mockLog[ i ].bus == bus && ( device < 0 || mockLog[ i ].device == device ) )
+            return mockLog[ i ].ns;
+    return mockNever;
+}
+
+
+//-----------------------------------------------------------------------------
+// keys
+//   a press is held for 50 ms, then the display gets 200 ms to finish
+//-----------------------------------------------------------------------------
+static void press( uint8_t pin ) {
+    mockSetPin( pin, LOW );
+    mockRun( 50000 );
+    mockSetPin( pin, HIGH );
+    mockRun( 200000 );
+}
+
+
+static void benchKey( const char *name, uint8_t pin, uint32_t maxBytes ) {
+    SCH.clearStats();
+    const size_t first = mockLog.size();
+    const uint64_t pressed = mockNanos();
+    press( pin );
+    const traffic_t t = traffic( first );
+    const uint64_t shown = firstEvent( first, mbI2c );
+    result( name, "i2c_bytes", t.i2cBytes, maxBytes );
+    result( name, "i2c_packets", t.i2cPackets );
+    result( name, "i2c_us", t.i2cNs / 1000 );
+    result( name, "spi_words", t.spiWords );
+    result( name, "shown_us", shown == mockNever ? 0 : ( shown - pressed ) / 1000,
+            Button::DEBOUNCE * task( "buttons" ).period * 1000 + 2000 );
+    result( name, "overruns", overruns(), 0 );
+}
+
+
+static void benchKeys() {
+    SCH.clearStats();
+    const size_t first = mockLog.size();
+    mockRun( 200000 );
+    const traffic_t t = traffic( first );
+    result( "redraw", "i2c_bytes", t.i2cBytes, 0 ); // unchanged menu
+    result( "redraw", "spi_words", t.spiWords, 0 );
+    result( "redraw", "overruns", overruns(), 0 );
+
+    benchKey( "cursor", btnRight, 64 );
+    for ( uint8_t i = 2; i < numDigits; ++i ) // least significant Hz digit of freq1
+        press( btnRight );
+    // without the frame buffer the unit is redrawn when the digit width changes
+    const uint32_t digitBytes = SH1106_FRAMEBUFFER ? 128 : 160;
+    benchKey( "digit", btnUp, digitBytes );
+    benchKey( "digit_back", btnDown, digitBytes );
+}
+
+
+//-----------------------------------------------------------------------------
+// sweep
+//   from one sync pulse to the next, the log is split tick by tick
+//-----------------------------------------------------------------------------
+static bool waitSync( uint32_t ms ) {
+    bool last = mockPin( testOut );
+    for ( uint32_t i = 0; i < ms; ++i ) {
+        mockRun( 1000 );
+        const bool sync = mockPin( testOut );
+        if ( sync && !last )
+            return true;
+        last = sync;
+    }
+    return false;
+}
+
+
+static void benchSweep() {
+    mockSerialInput( "20000F\nX\n1000F\nJ\n" ); // freq2 20 kHz, freq1 1 kHz, 30 s
+    mockRun( 20000 ); // received and started
+    const bool started = waitSync( 31000 );
+    result( "sweep", "started", !started, 0 );
+    if ( !started )
+        return;
+    SCH.clearStats();
+    const size_t first = mockLog.size();
+    const uint64_t start = mockNanos();
+    uint32_t ticks = 0;
+    uint32_t maxWords = 0;
+    uint64_t maxNs = 0;
+    uint32_t steps = 0;
+    bool last = true;
+    for ( ; ticks < 32000; ++ticks ) {
+        const size_t before = mockLog.size();
+        mockRun( 1000 );
+        const traffic_t t = traffic( before );
+        if ( t.spiWords > maxWords )
+            maxWords = t.spiWords;
+        if ( t.spiNs > maxNs )
+            maxNs = t.spiNs;
+        if ( firstEvent( before, mbSpi, adSelect ) != mockNever )
+            ++steps;
+        const bool sync = mockPin( testOut );
+        if ( sync && !last )
+            break;
+        last = sync;
+    }
+    const traffic_t t = traffic( first );
+    const uint64_t period = mockNanos() - start;
+    result( "sweep", "period_ms", period / 1000000 );
+    result( "sweep", "period_error_us", llabs( int64_t( period ) - 30000000000LL ) / 1000,
+            1000 * task( "sweep" ).period );
+    result( "sweep", "steps", steps );
+    result( "sweep", "spi_words", t.spiWords );
+    result( "sweep", "spi_words_max", maxWords, 5 );
+    result( "sweep", "spi_us", t.spiNs / 1000 );
+    result( "sweep", "spi_us_max", maxNs / 1000, 20 );
+    result( "sweep", "i2c_bytes", t.i2cBytes );
+    result( "sweep", "overruns", overruns(), 0 );
+
+    mockSerialInput( "F\n" ); // constant again
+    mockRun( 200000 );
+}
+
+
+//-----------------------------------------------------------------------------
+// serial
+//   latency from the end of the command character to the first transaction
+//   on the bus it changes: AD9833, digital pot or the serial answer
+//-----------------------------------------------------------------------------
+struct command_t {
+    const char *name;
+    const char *text; // the command character is the last one before '\n'
+    mockBus_t bus;
+    int device;
+    uint32_t maxUs;
+};
+
+
+static void benchCommand( const command_t &c ) {
+    SCH.clearStats();
+    mockSerialOutput();
+    const size_t first = mockLog.size();
+    mockSerialInput( c.text );
+    mockRun( 100000 );
+    const char command = c.text[ strlen( c.text ) - 2 ];
+    uint64_t received = mockNever;
+    for ( size_t i = first; i < mockLog.size(); ++i ) {
+        const mockEvent_t &e = mockLog[ i ];
+        if ( e.bus == mbSerialRx && e.data == uint8_t( command ) ) {
+            received = e.ns + e.duration;
+            break;
+        }
+    }
+    uint64_t done = mockNever;
+    for ( size_t i = first; i < mockLog.size(); ++i ) {
+        const mockEvent_t &e = mockLog[ i ];
+        if ( e.ns >= received && e.bus == c.bus && ( c.device < 0 || e.device == c.device ) ) {
+            done = e.ns;
+            break;
+        }
+    }
+    const traffic_t t = traffic( first );
+    result( c.name, "latency_us", done == mockNever ? noLimit : ( done - received ) / 1000, c.maxUs );
+    result( c.name, "spi_words", t.spiWords );
+    result( c.name, "i2c_bytes", t.i2cBytes );
+    result( c.name, "overruns", overruns(), 0 );
+}
+
+
+static void benchSerial() {
+    // up to one tick until the serial task reads the command, the sweep task writes the output a tick later
+    const uint32_t output = 2 * 1000 * task( "serial" ).period + task( "sweep" ).deadline;
+    static const command_t session[] = {
+        { "freq", "2000F\n", mbSpi, adSelect, output },
+        { "freq_mhz", "1234.567F\n", mbSpi, adSelect, output },
+        { "wave", "T\n", mbSpi, adSelect, output },
+        { "level", "-10D\n", mbSpi, potSelect, output },
+        { "query", "Q\n", mbSerialTx, -1, output },
+        { "telemetry_on", "20#Q\n", mbSerialTx, -1, 25000 }, // first line after 20 ms
+        { "freq_telemetry", "3000F\n", mbSpi, adSelect, output },
+        { "level_telemetry", "-20D\n", mbSpi, potSelect, output },
+    };
+    for ( const command_t &c : session )
+        benchCommand( c );
+    mockSerialInput( "0#Q\n" );
+    mockRun( 100000 );
+}
+
+
+int main() {
+    setup();
+    mockRun( 500000 ); // power-on, display init
+    mockSerialOutput();
+
+    benchKeys();
+    benchSweep();
+    benchSerial();
+
+    printf( "bench,result,fails,%u,0,%s\n", fails, fails ? "FAIL" : "PASS" );
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# ino2cpp.py
+#   turn the sketch into a C++ file like the Arduino builder does:
+#   include Arduino.h and declare all functions before the first definition
+#
+#   usage: python3 ino2cpp.py SignalGenerator3.ino build/SignalGenerator3.cpp
+
+import re
+import sys
+
+KEYWORDS = ( 'else', 'if', 'for', 'while', 'switch', 'return', 'case', 'do',
+             'typedef', 'struct', 'class', 'enum', 'union', 'static_assert' )
+
+# a function definition at the start of a line: type name( args ) {
+DEFINITION = re.compile( r'^([A-Za-z_][\w<>\*&: ]*?[\s\*&]+)([A-Za-z_]\w*)\s*\(([^;{}]*)\)\s*(const\s*)?\{' )
+
+
+def main():
+    source, target = sys.argv[ 1 ], sys.argv[ 2 ]
+    lines = open( source ).read().split( '\n' )
+    prototypes = []
+    first = None
+    for i, line in enumerate( lines ):
+        m = DEFINITION.match( line )
+        if not m or m.group( 1 ).split()[ 0 ] in KEYWORDS:
+            continue
+        if first is None:
+            first = i
+        prototypes.append( m.group( 1 ) + m.group( 2 ) + '(' + m.group( 3 ) + ');' )
+    out = [ '#include <Arduino.h>', '#line 1 "%s"' % source ]
+    out += lines[ :first ] + prototypes
+    out += [ '#line %d "%s"' % ( first + 1, source ) ] + lines[ first: ]
+    open( target, 'w' ).write( '\n'.join( out ) )
+
+
+main()
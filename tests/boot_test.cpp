@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    boot_test.cpp
+    Smoke test of the host build: power-on, display init and one serial
+    command, the resulting SPI words are checked with their timestamps
+*/
+
+#include "AD9833.h"
+#include "Mock.h"
+#include "TwiQueue.h"
+
+void setup();
+
+static int fails = 0;
+
+static void check( bool ok, const char *what ) {
+    if ( !ok ) {
+        ++fails;
+        printf( "FAIL: %s\n", what );
+    }
+}
+
+
+int main() {
+    setup();
+    mockRun( 100000 );
+    check( mockSerialOutput().find( "Signal Generator 3" ) == 0, "version line at power-on" );
+    check( TwiQ.packets > 0 && !TwiQ.busy(), "display init sent" );
+    check( mockDisplay[ 0 ][ 0 ] != 0, "display frame drawn" );
+
+    // 1 kHz: FREQ0 LSBs = round( 1000 * 2^28 / 25 MHz ) = 10737, the MSBs stay 0
+    const size_t first = mockLog.size();
+    mockSerialInput( "1000F\n" );
+    mockRun( 5000 );
+    uint64_t received = 0; // end of the 'F'
+    uint64_t written = 0;
+    uint64_t last = 0;
+    bool ordered = true;
+    for ( size_t i = first; i < mockLog.size(); ++i ) {
+        const mockEvent_t &e = mockLog[ i ];
+        if ( e.bus == mbSerialRx && e.data == 'F' )
+            received = e.ns + e.duration;
+        if ( e.bus != mbSpi )
+            continue;
+        ordered = ordered && e.ns >= last;
+        last = e.ns + e.duration;
+        if ( e.device == 10 && e.data == ( 0x4000 | AD9833::freqWord( 1000 ) ) && !written )
+            written = e.ns;
+    }
+    check( ordered, "SPI transactions do not overlap" );
+    check( received && written > received, "FREQ0 written after the command" );
+    check( written - received < 2000000, "FREQ0 written within 2 ms" );
+    printf( "1000F: FREQ0 written %.3f ms after the command\n", ( written - received ) / 1e6 );
+
+    if ( fails )
+        printf( "%d failed\n", fails );
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    freqword_test.cpp
+    AD9833::freqWord() against the reference round( f * 2^28 / MCLK ):
+    every Hz from 0 to 12.5 MHz, the mHz grid of the low frequencies
+    and of every 9973th Hz. The reference is computed with 64 bit integers,
+    the former float formula ( AVR double = 32 bit float ) is printed for comparison:
+      FREQ = f * ( 0x10000000L / 25000000.0 ) + 0.5
+*/
+
+#include "AD9833.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int fails = 0;
+
+// round half up like freqWord()
+static uint32_t reference( uint32_t hz, uint16_t milliHz ) {
+    const uint64_t milli = uint64_t( hz ) * 1000 + milliHz;
+    const uint64_t div = uint64_t( AD9833::MCLK ) * 1000;
+    return ( ( milli << 28 ) + div / 2 ) / div;
+}
+
+
+static uint32_t formerWord( uint32_t hz ) { return uint32_t( float( hz ) * ( 0x10000000L / 25000000.0f ) + 0.5f ); }
+
+
+static void test( uint32_t hz, uint16_t milliHz ) {
+    const uint32_t fw = AD9833::freqWord( hz, milliHz );
+    const uint32_t ref = reference( hz, milliHz );
+    if ( fw != ref && ++fails <= 10 )
+        printf( "FAIL: %lu.%03u Hz: 0x%07lX, expected 0x%07lX\n", (unsigned long)hz, milliHz, (unsigned long)fw,
+                (unsigned long)ref );
+}
+
+
+int main() {
+    const uint32_t top = AD9833::MCLK / 2;
+    long formerWorst = 0;
+    uint32_t formerWrong = 0;
+    for ( uint32_t hz = 0; hz <= top; ++hz ) {
+        test( hz, 0 );
+        const long diff = labs( long( formerWord( hz ) ) - long( reference( hz, 0 ) ) );
+        if ( diff ) {
+            ++formerWrong;
+            if ( diff > formerWorst )
+                formerWorst = diff;
+        }
+    }
+    for ( uint32_t hz = 0; hz < 2000; ++hz )
+        for ( uint16_t milliHz = 0; milliHz < 1000; ++milliHz )
+            test( hz, milliHz );
+    for ( uint32_t hz = 0; hz < top; hz += 9973 )
+        for ( uint16_t milliHz = 0; milliHz < 1000; ++milliHz )
+            test( hz, milliHz );
+    test( 999, 1000 ); // mHz carry into Hz
+    test( top - 1, 65535 );
+    printf( "float formula: %lu of %lu Hz values wrong, max %ld LSB\n", (unsigned long)formerWrong,
+            (unsigned long)top + 1, formerWorst );
+
+    if ( fails )
+        printf( "%d failed\n", fails );
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    level_test.cpp
+    potFromdB() and dBfromValue() of the sketch against the former
+    formulas for dBm, dBu and dBV, levels in 0.1 dB:
+      dB  = 20 * log10( ( value + 1 ) / 256 ) + full scale
+      pot = round( 256 * 10^( ( dB - full scale ) / 20 ) ) - 1
+    every pot value, every level from -70.0 to +15.0 dB,
+    and the whole dB levels of the former code
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum dB_t { dBm = 0, dBu, dBV };
+extern dB_t dBtype;
+int16_t dBfromValue( int value );
+int potFromdB( int value );
+
+static int fails = 0;
+
+static void check( bool ok, const char *what, const char *unit, int value, long got, long expected ) {
+    if ( !ok && ++fails <= 20 )
+        printf( "FAIL: %s %s %d: %ld, expected %ld\n", unit, what, value, got, expected );
+}
+
+
+int main() {
+    static const char *const units[] = { "dBm", "dBu", "dBV" };
+    static const float fullScale[] = { 7.0f, 3.0f, 1.1f }; // of the former code
+    for ( int unit = dBm; unit <= dBV; ++unit ) {
+        dBtype = dB_t( unit );
+        const double fs = fullScale[ unit ];
+
+        for ( int value = 0; value < 256; ++value ) {
+            const long expected = lround( 200 * log10( ( value + 1 ) / 256.0 ) + 10 * fs );
+            check( dBfromValue( value ) == expected, "dBfromValue", units[ unit ], value, dBfromValue( value ),
+                   expected );
+            // the former code rounded to whole dB
+            const long former = lround( 20 * log10( ( value + 1 ) / 256.0 ) + fs );
+            check( labs( dBfromValue( value ) - 10 * former ) <= 5, "dBfromValue, former whole dB", units[ unit ],
+                   value, dBfromValue( value ), 10 * former );
+        }
+
+        for ( int dB10 = -700; dB10 <= 150; ++dB10 ) {
+            long expected = lround( 256 * pow( 10.0, ( dB10 / 10.0 - fs ) / 20 ) ) - 1;
+            if ( expected > 255 )
+                expected = 255;
+            check( potFromdB( dB10 ) == expected, "potFromdB", units[ unit ], dB10, potFromdB( dB10 ), expected );
+        }
+
+        for ( int dB = -70; dB <= int( fs ); ++dB ) {
+            const long former = lround( 256 * pow( 10.0, ( dB - fs ) / 20.0 ) ) - 1;
+            check( potFromdB( 10 * dB ) == former, "potFromdB, former whole dB", units[ unit ], dB,
+                   potFromdB( 10 * dB ), former );
+        }
+
+        // round trip: the level of a pot value sets a pot value of the same level
+        for ( int value = 0; value < 256; ++value ) {
+            const int16_t dB10 = dBfromValue( value );
+            check( dBfromValue( potFromdB( dB10 ) ) == dB10, "round trip", units[ unit ], value,
+                   dBfromValue( potFromdB( dB10 ) ), dB10 );
+        }
+    }
+    dBtype = dBm;
+
+    if ( fails )
+        printf( "%d failed\n", fails );
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+    sweep_test.cpp
+    Accuracy of the Sweep engine against the exact sweep and against
+    the former float formula of stepSweep() ( AVR double = 32 bit float ):
+      f = exp( ( log( stop ) - log( start ) ) * pos / steps + log( start ) ) + 0.5
+      FREQ = f * ( 2^28 / 25 MHz ) + 0.5
+    Errors are printed in Hz, the engine must not be worse than the float formula
+*/
+
+#include "Sweep.h"
+#include <stdio.h>
+
+static int fails = 0;
+
+static void check( bool ok, const char *what, long from, long to, long steps ) {
+    if ( !ok ) {
+        ++fails;
+        printf( "FAIL: %s, %ld -> %ld Hz, %ld steps\n", what, from, to, steps );
+    }
+}
+
+
+static const double lsbHz = 25e6 / 268435456.0;
+
+static uint32_t floatWord( float hz ) { return uint32_t( hz * ( 0x10000000L / 25000000.0f ) + 0.5f ); }
+
+
+static uint32_t formerLog( long from, long to, long pos, long steps ) {
+    const long f = expf( ( logf( to ) - logf( from ) ) * pos / steps + logf( from ) ) + 0.5f;
+    return floatWord( f );
+}
+
+
+// log and linear sawtooth: steps + 1 values, then the start again
+static void testSawtooth( long from, long to, long steps, bool logarithmic ) {
+    const uint32_t fwFrom = floatWord( from );
+    const uint32_t fwTo = floatWord( to );
+    Sweep s;
+    s.arm( fwFrom, fwTo, steps, logarithmic );
+    double worst = 0;
+    double formerWorst = 0;
+    for ( long pos = 0; pos <= steps; ++pos ) {
+        const double exact = logarithmic ? fwFrom * pow( double( fwTo ) / fwFrom, double( pos ) / steps )
+                                         : fwFrom + ( double( fwTo ) - fwFrom ) * pos / steps;
+        const uint32_t fw = s.step();
+        worst = fmax( worst, fabs( fw - exact ) );
+        if ( logarithmic )
+            formerWorst = fmax( formerWorst, fabs( formerLog( from, to, pos, steps ) - exact ) );
+    }
+    check( s.step() == fwFrom, "restart with the start value", from, to, steps );
+    check( s.atStart(), "start flag", from, to, steps );
+    if ( logarithmic ) {
+        printf( "log %8ld -> %8ld Hz, %5ld steps: max error %8.3f Hz, float formula %8.3f Hz\n", from, to, steps,
+                worst * lsbHz, formerWorst * lsbHz );
+        check( worst <= fmax( formerWorst, 1.0 ), "log sweep worse than the float formula", from, to, steps );
+    } else {
+        printf( "lin %8ld -> %8ld Hz, %5ld steps: max error %8.3f Hz\n", from, to, steps, worst * lsbHz );
+        check( worst <= 0.5 + 1e-9, "linear sweep off by more than 1/2 LSB", from, to, steps );
+    }
+}
+
+
+// triangle: steps values up, steps values down, the way back mirrors the way up
+static void testTriangle( long from, long to, long steps ) {
+    const uint32_t fwFrom = floatWord( from );
+    const uint32_t fwTo = floatWord( to );
+    Sweep s;
+    s.arm( fwFrom, fwTo, steps, true, true );
+    double worst = 0;
+    for ( long pos = 0; pos < 2 * steps; ++pos ) {
+        const long p = pos < steps ? pos : 2 * steps - pos;
+        const double exact = fwFrom * pow( double( fwTo ) / fwFrom, double( p ) / steps );
+        worst = fmax( worst, fabs( s.step() - exact ) );
+    }
+    check( s.step() == fwFrom, "triangle returns to the start value", from, to, steps );
+    printf( "tri %8ld -> %8ld Hz, %5ld steps: max error %8.3f Hz\n", from, to, steps, worst * lsbHz );
+    check( worst * lsbHz <= 1e-6 * to + lsbHz, "triangle error above 1 ppm", from, to, steps );
+}
+
+
+int main() {
+    static const long cases[][ 3 ] = {
+        { 1000, 20000, 1000 }, { 1000, 20000, 30000 }, { 100000, 1000000, 30000 }, { 1000000, 9000000, 30000 },
+        { 1, 9999999, 30000 }, { 20000, 1000, 30000 }, { 9999999, 1, 1000 }, { 100, 101, 30000 }, { 5, 10, 3 },
+        { 20, 12500000, 3600 },
+    };
+    for ( const auto &c : cases ) {
+        testSawtooth( c[ 0 ], c[ 1 ], c[ 2 ], true );
+        testSawtooth( c[ 0 ], c[ 1 ], c[ 2 ], false );
+    }
+    testSawtooth( 0, 1000, 1000, false );
+    testTriangle( 1000, 20000, 1000 );
+    testTriangle( 20000, 1000, 30000 );
+
+    if ( fails )
+        printf( "%d failed\n", fails );
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# levels.py
+#   generate LevelTables.h, the level tables of the MCP41010 digital pot
+#   in 0.1 dB relative to full scale ( pot value 255 = 256/256 )
+#   same formulas as the former float code of the sketch:
+#     dB  = 20 * log10( ( value + 1 ) / 256 )
+#     pot = round( 256 * 10^( dB / 20 ) ) - 1
+#
+#   usage: python3 tools/levels.py > LevelTables.h
+
+import math
+
+POTS = 256
+
+
+def cround( x ): # like C round(), halfway cases away from zero
+    return int( math.copysign( math.floor( abs( x ) + 0.5 ), x ) )
+
+
+def pot_to_dB10( value ):
+    return cround( 200 * math.log10( ( value + 1 ) / POTS ) )
+
+
+def dB10_to_pot( dB10 ):
+    return cround( POTS * 10 ** ( dB10 / 200 ) ) - 1
+
+
+def main():
+    potTodB = [ pot_to_dB10( v ) for v in range( POTS ) ]
+    dBToPot = []
+    while dB10_to_pot( -len( dBToPot ) ) >= 0:
+        dBToPot.append( dB10_to_pot( -len( dBToPot ) ) )
+
+    # consistency: monotonic and a level survives the round trip
+    assert all( a <= b for a, b in zip( potTodB, potTodB[ 1: ] ) )
+    assert all( a >= b for a, b in zip( dBToPot, dBToPot[ 1: ] ) )
+    assert dBToPot[ 0 ] == POTS - 1
+    for v in range( POTS ):
+        assert potTodB[ dBToPot[ -potTodB[ v ] ] ] == potTodB[ v ], v
+
+    print( '''// SPDX-License-Identifier: GPL-3.0-or-later
+//******************************************
+//  LevelTables.h
+//    Level tables of the MCP41010 digital pot in 0.1 dB
+//    relative to full scale ( pot value 255 )
+//    generated by tools/levels.py, do not edit
+//
+//******************************************
+
+#pragma once
+
+#include <avr/pgmspace.h>
+''' )
+    print( '// pot value -> level: round( 200 * log10( ( value + 1 ) / 256 ) )' )
+    print( 'const int16_t potTodB10[ %d ] PROGMEM = {' % POTS )
+    for i in range( 0, POTS, 16 ):
+        print( '    ' + ', '.join( '%d' % x for x in potTodB[ i:i + 16 ] ) + ',' )
+    print( '};\n' )
+    print( '// level i * 0.1 dB below full scale -> pot value: round( 256 * 10^( -i / 200 ) ) - 1' )
+    print( '// lower levels are off' )
+    print( 'const uint16_t dB10Range = %d;' % len( dBToPot ) )
+    print( 'const uint8_t dB10ToPot[ dB10Range ] PROGMEM = {' )
+    for i in range( 0, len( dBToPot ), 20 ):
+        print( '    ' + ', '.join( '%d' % x for x in dBToPot[ i:i + 20 ] ) + ',' )
+    print( '};' )
+
+
+main()